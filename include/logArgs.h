@@ -0,0 +1,208 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_ARGS
+#define SIOF_LOGGER_ARGS
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "logConfig.h"
+
+namespace siof
+{
+    /// type tag stored before every encoded argument
+    enum LogArgType
+    {
+        SLOG_ARG_INT            = 0,
+        SLOG_ARG_UINT           = 1,
+        SLOG_ARG_DOUBLE         = 2,
+        SLOG_ARG_STRING         = 3,
+        SLOG_ARG_POINTER        = 4,
+        /// field name (stored like string), next argument is field value
+        SLOG_ARG_KEY            = 5,
+        SLOG_ARG_BOOL           = 6,
+
+        SLOG_ARG_COUNT
+    };
+
+    /// how lines (and structured fields) are rendered
+    enum LogFormat
+    {
+        /// "YYYY-MM-DD HH:MM:SS.mmm [LEVEL] msg key=value ..."
+        SLOG_FORMAT_TEXT        = 0,
+        /// logfmt: "ts=YYYY-MM-DDTHH:MM:SS.mmm+hh:mm level=LEVEL msg="..." key=value ..."
+        SLOG_FORMAT_LOGFMT      = 1,
+        /// JSON Lines: {"ts":"...","level":"LEVEL","msg":"...","key":value,...}
+        SLOG_FORMAT_JSON        = 2,
+
+        SLOG_FORMAT_COUNT
+    };
+
+    /// named value of structured message (created by kv)
+    template <typename T>
+    struct LogField
+    {
+        const char * key;
+        const T & value;
+    };
+
+    /// field for Logger::Log - stored typed and rendered by logging thread after formatted text,
+    /// e.g. logger.Log(SLOG_LEVEL_INFO, "request done", kv("user", id), kv("ms", dt));
+    template <typename T>
+    LogField<T> kv(const char * key, const T & value)
+    {
+        LogField<T> field = { key, value };
+        return field;
+    }
+
+    /// Encodes printf arguments into byte buffer on producer side and formats them later
+    /// (on logging thread). Every argument is stored as one type byte followed by
+    /// 8 byte value or (for strings) 4 byte length and string bytes.
+    /// Integers are widened to 64 bit, so format length modifiers don't matter.
+    /// Fields (kv) are stored as key followed by value and are skipped by format conversions.
+    class LogArgs
+    {
+    public:
+        /// replaces out content with encoded args
+        template <typename... Args>
+        static void Encode(std::string & out, const Args &... args)
+        {
+            out.clear();
+
+            int expand[] = { 0, (EncodeArg(out, args), 0)... };
+            (void)expand;
+        }
+
+        /// appends text for printf like fmt with args encoded by Encode to out
+        static void Format(const char * fmt, const char * args, std::size_t size, std::string & out);
+
+        /// async-signal-safe variant of Format (used by crash handler): no allocations, flags, width
+        /// and precision are ignored, doubles are written with 6 decimals. Writes at most outSize bytes
+        /// to out and returns written size.
+        static std::size_t FormatSafe(const char * fmt, const char * args, std::size_t size, char * out, std::size_t outSize);
+
+        /// appends fields (kv args) to out - " key=value" for text and logfmt (characters of key other than
+        /// [A-Za-z0-9_.-] are replaced by '_'), ",\"key\":value" for JSON
+        static void FormatFields(const char * args, std::size_t size, LogFormat format, std::string & out);
+
+        /// appends data escaped for JSON string (without quotes)
+        static void AppendEscaped(const char * data, std::size_t size, std::string & out);
+
+        /// appends data as logfmt value (quoted and escaped only if needed)
+        static void AppendLogfmtValue(const char * data, std::size_t size, std::string & out);
+
+    private:
+        static void EncodeArg(std::string & out, const char * value)
+        {
+            if (!value)
+                value = "(null)";
+
+            EncodeString(out, value, std::strlen(value));
+        }
+
+        static void EncodeArg(std::string & out, char * value)
+        {
+            EncodeArg(out, static_cast<const char *>(value));
+        }
+
+        static void EncodeArg(std::string & out, const std::string & value)
+        {
+            EncodeString(out, value.data(), value.size());
+        }
+
+        static void EncodeArg(std::string & out, bool value)
+        {
+            EncodeRaw(out, SLOG_ARG_BOOL, std::uint64_t(value));
+        }
+
+        static void EncodeArg(std::string & out, double value)
+        {
+            EncodeRaw(out, SLOG_ARG_DOUBLE, value);
+        }
+
+        static void EncodeArg(std::string & out, long double value)
+        {
+            EncodeRaw(out, SLOG_ARG_DOUBLE, double(value));
+        }
+
+        template <typename T>
+        static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type EncodeArg(std::string & out, T value)
+        {
+            EncodeRaw(out, SLOG_ARG_INT, std::int64_t(value));
+        }
+
+        template <typename T>
+        static typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type EncodeArg(std::string & out, T value)
+        {
+            EncodeRaw(out, SLOG_ARG_UINT, std::uint64_t(value));
+        }
+
+        template <typename T>
+        static typename std::enable_if<std::is_enum<T>::value>::type EncodeArg(std::string & out, T value)
+        {
+            EncodeRaw(out, SLOG_ARG_INT, std::int64_t(value));
+        }
+
+        template <typename T>
+        static void EncodeArg(std::string & out, const T * value)
+        {
+            EncodeRaw(out, SLOG_ARG_POINTER, std::uint64_t(reinterpret_cast<std::uintptr_t>(value)));
+        }
+
+        template <typename T>
+        static void EncodeArg(std::string & out, const LogField<T> & field)
+        {
+            const char * key = field.key ? field.key : "";
+
+            EncodeString(out, key, std::strlen(key), SLOG_ARG_KEY);
+            EncodeArg(out, field.value);
+        }
+
+        template <typename T>
+        static void EncodeRaw(std::string & out, LogArgType type, T value)
+        {
+            static_assert(sizeof(T) == 8, "encoded values have to be 8 bytes long");
+
+            char buffer[1 + sizeof(T)];
+            buffer[0] = char(type);
+            std::memcpy(buffer + 1, &value, sizeof(T));
+
+            out.append(buffer, sizeof(buffer));
+        }
+
+        static void EncodeString(std::string & out, const char * value, std::size_t size, LogArgType type = SLOG_ARG_STRING)
+        {
+            std::uint32_t tmpSize = std::uint32_t(size);
+
+            char buffer[1 + sizeof(tmpSize)];
+            buffer[0] = char(type);
+            std::memcpy(buffer + 1, &tmpSize, sizeof(tmpSize));
+
+            out.append(buffer, sizeof(buffer));
+            out.append(value, tmpSize);
+        }
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logArgs.cpp"
+#endif
+
+#endif // SIOF_LOGGER_ARGS
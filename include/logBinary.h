@@ -0,0 +1,94 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_BINARY
+#define SIOF_LOGGER_BINARY
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "logConfig.h"
+#include "logMsg.h"
+
+namespace siof
+{
+    #define SLOG_BINARY_MAGIC       "SLOGBIN1"
+    #define SLOG_BINARY_MAGIC_SIZE  8
+    /// last byte of every record (never 0, so zero filled tail of mapped file can be cut safely)
+    #define SLOG_BINARY_RECORD_END  '\n'
+    /// decoder reads strings in parts of this size - size stored in corrupted file can't make it allocate more than file holds
+    #define SLOG_BINARY_READ_CHUNK  (64 * 1024)
+
+    /// Binary log file layout - sequence of records, each starts with type byte:
+    /// SESSION: magic, varint base time (ns), varint separator size, separator
+    /// FORMAT:  varint format id, varint size, format string
+    /// MSG:     varint time delta (ns, zigzag), level byte, varint format id (0 - ready text),
+    ///          varint packed args size, packed args
+    /// CATEGORY: varint category id, varint size, category name
+    /// CATEGORY_MSG: varint category id, then MSG record fields
+    /// Packed args are LogArgs values with varint integers and strings (field keys like strings).
+    enum LogBinaryRecord
+    {
+        SLOG_BIN_SESSION        = 1,
+        SLOG_BIN_FORMAT         = 2,
+        SLOG_BIN_MSG            = 3,
+        SLOG_BIN_CATEGORY       = 4,
+        SLOG_BIN_CATEGORY_MSG   = 5
+    };
+
+    /// Writes messages as binary records (used by logging thread instead of LogMsg::Render).
+    /// Format strings and category names are interned per session - every one is written once.
+    class LogBinaryEncoder
+    {
+    public:
+        LogBinaryEncoder() : lastTime_(0) {}
+
+        /// appends SESSION record and forgets interned strings (call for every opened file)
+        void StartSession(std::string & out, const std::string & separator);
+
+        /// appends MSG / CATEGORY_MSG record (preceded by FORMAT / CATEGORY record for new string)
+        void Encode(const LogMsg & msg, std::string & out);
+
+    private:
+        typedef std::unordered_map<const char *, std::uint32_t> StringIds;
+
+        /// returns id of string (appends record of given type when string is new)
+        static std::uint32_t Intern(StringIds & ids, LogBinaryRecord type, const char * str, std::string & out);
+
+        std::int64_t lastTime_;
+        StringIds formats_;
+        StringIds categories_;
+        std::string packed_;
+    };
+
+    /// Turns binary log back into lines produced by LogMsg::Render
+    class LogBinaryDecoder
+    {
+    public:
+        /// decodes all records from in to out (rendered as format), returns false for corrupted input
+        bool Decode(std::istream & in, std::ostream & out, LogFormat format = SLOG_FORMAT_TEXT);
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logBinary.cpp"
+#endif
+
+#endif // SIOF_LOGGER_BINARY
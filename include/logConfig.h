@@ -0,0 +1,29 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_CONFIG
+#define SIOF_LOGGER_CONFIG
+
+/// SLOG_HEADER_ONLY - headers include implementation files (src/ has to be on include path),
+/// so no library is linked and compiler sees whole logger in every translation unit
+#ifdef SLOG_HEADER_ONLY
+#define SLOG_INLINE inline
+#else
+#define SLOG_INLINE
+#endif
+
+#endif // SIOF_LOGGER_CONFIG
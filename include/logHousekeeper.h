@@ -0,0 +1,81 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_HOUSEKEEPER
+#define SIOF_LOGGER_HOUSEKEEPER
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "logConfig.h"
+
+namespace siof
+{
+    /// Background thread which removes old log files (<name>_YYYY_MM_DD[_N].<ext>[.gz]) so that at most
+    /// max files / max total bytes are kept. Logging thread only calls Notify after rollover,
+    /// directory listing and deleting is done here.
+    class LogHousekeeper
+    {
+    public:
+        LogHousekeeper() : maxFiles_(0), maxBytes_(0), pending_(false), closing_(false) {}
+        ~LogHousekeeper();
+
+        /// sets limits (0 - no limit), counts include active file
+        void SetRetention(std::size_t maxFiles, std::uint64_t maxBytes);
+
+        /// returns if any limit is set
+        bool IsEnabled() const;
+
+        /// schedules cleanup of files created for fileName (path without date suffix) with given extension,
+        /// activeFile is never removed. Starts thread if needed.
+        void Notify(const std::string & fileName, const std::string & extension, const std::string & activeFile);
+
+        /// stops thread (pending cleanup is finished first)
+        void Stop();
+
+    private:
+        LogHousekeeper(const LogHousekeeper &);
+        LogHousekeeper & operator = (const LogHousekeeper &);
+
+        void Run();
+        void Cleanup(const std::string & fileName, const std::string & extension, const std::string & activeFile,
+                     std::size_t maxFiles, std::uint64_t maxBytes);
+
+        std::size_t maxFiles_;
+        std::uint64_t maxBytes_;
+
+        std::string fileName_;
+        std::string extension_;
+        std::string activeFile_;
+        bool pending_;
+        bool closing_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable cond_;
+        std::shared_ptr<std::thread> thread_;
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logHousekeeper.cpp"
+#endif
+
+#endif // SIOF_LOGGER_HOUSEKEEPER
@@ -18,14 +18,19 @@
 #ifndef SIOF_LOGGER_MSG
 #define SIOF_LOGGER_MSG
 
+#include <atomic>
 #include <chrono>
 #include <ctime>
+#include <memory>
+#include <ostream>
 #include <string>
 
+#include "logConfig.h"
+#include "logArgs.h"
+#include "logTime.h"
+
 namespace siof
 {
-    typedef std::chrono::time_point<std::chrono::system_clock, std::chrono::system_clock::duration> LogTimePoint;
-
     enum LogLevel
     {
         SLOG_LEVEL_NONE         = 0,
@@ -41,30 +46,99 @@ namespace siof
         SLOG_LEVEL_COUNT
     };
 
+    /// completion flag of message which producer waits for (Logger::SetSyncLevel)
+    struct LogMsgSync
+    {
+        LogMsgSync() : written(false) {}
+
+        /// set by logging thread once message is durably written (or dropped by overflow policy)
+        std::atomic<bool> written;
+    };
+
     class LogMsg
     {
     public:
-        LogMsg(){}
+        LogMsg() : logLevel_(SLOG_LEVEL_NONE), category_(nullptr), fmt_(nullptr) {}
         LogMsg(const LogMsg& p);
         LogMsg(LogLevel logLevel, const std::string & msg);
         ~LogMsg(){}
 
+        /// refills message in place (keeps msg buffer capacity)
+        void Set(LogLevel logLevel, const std::string & msg);
+
+        /// refills message in place with not yet formatted text - only fmt pointer
+        /// and encoded args are stored, so fmt has to live until message is written
+        template <typename... Args>
+        void SetFormat(LogLevel logLevel, const char * fmt, const Args &... args)
+        {
+            time_ = std::chrono::system_clock::now();
+            logLevel_ = logLevel;
+            category_ = nullptr;
+            fmt_ = fmt;
+            LogArgs::Encode(args_, args...);
+            sync_.reset();
+        }
+
+        /// refills message with fmt and args already encoded by LogArgs (e.g. decoded from binary log)
+        void SetEncoded(LogLevel logLevel, const char * fmt, const std::string & args);
+
+        /// builds msg text from fmt and args (if message was set by SetFormat)
+        void Format();
+
+        /// returns format string (nullptr if message was set with ready text)
+        const char * GetFormat() const;
+        /// returns args encoded by LogArgs
+        const std::string & GetArgs() const;
+
         const std::string & GetMsg() const;
-        inline std::time_t GetCTime() const;
+        std::time_t GetCTime() const;
         const LogTimePoint & GetTime() const;
+        void SetTime(const LogTimePoint & time);
+        LogLevel GetLogLevel() const;
+
+        /// sets category name (nullptr - none), name has to live until message is written
+        void SetCategory(const char * category) { category_ = category; }
+        const char * GetCategory() const { return category_; }
+
+        /// returns if message has same level, category and content as other one (time is not compared)
+        bool IsRepeatOf(const LogMsg & other) const;
+
+        /// reserves capacity for text and encoded args (kept when message is set again)
+        void Reserve(std::size_t msgSize, std::size_t argsSize);
+
+        /// attaches completion flag (message is not copied with it)
+        void SetSync(const std::shared_ptr<LogMsgSync> & sync) { sync_ = sync; }
+        /// detaches completion flag
+        std::shared_ptr<LogMsgSync> TakeSync() { return std::move(sync_); }
+
+        /// appends whole log line ("YYYY-MM-DD HH:MM:SS.mmm [LEVEL] [category] msg key=value\n" for text format)
+        /// to out, returns position of message text in out (line start for logfmt and JSON)
+        std::size_t Render(std::string & out, LogTimeCache & timeCache, LogFormat format = SLOG_FORMAT_TEXT) const;
 
         friend std::ostream & operator<< (std::ostream & out, const LogMsg & msg);
 
         LogMsg & operator = (const LogMsg & p);
 
-        static inline std::string GetLogLevelStr(LogLevel logLevel);
+        static const char * GetLogLevelStr(LogLevel logLevel);
+        /// returns level name without brackets ("DEBUG")
+        static const char * GetLogLevelName(LogLevel logLevel);
 
     private:
 
         LogTimePoint time_;
         LogLevel logLevel_;
+        const char * category_;
         std::string msg_;
+
+        const char * fmt_;
+        std::string args_;
+
+        std::shared_ptr<LogMsgSync> sync_;
 };
 }
 
+#ifdef SLOG_HEADER_ONLY
+#include "logMsg.cpp"
+#endif
+
 #endif // SIOF_LOGGER_MSG
@@ -0,0 +1,103 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_RATE_LIMIT
+#define SIOF_LOGGER_RATE_LIMIT
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "logConfig.h"
+
+namespace siof
+{
+    /// slots of Logger rate limit table (power of 2) - message kinds sharing slot share limit
+    #ifndef SLOG_RATE_LIMIT_SLOTS
+    #define SLOG_RATE_LIMIT_SLOTS   1024
+    #endif
+
+    /// Token bucket of one call site or message kind. Lock-free GCRA: state is single atomic
+    /// "theoretical arrival time", so check costs clock read and (for allowed message) one CAS.
+    class LogRateLimit
+    {
+    public:
+        constexpr LogRateLimit() : tat_(0), suppressed_(0) {}
+
+        /// returns time between messages (nanoseconds) for given rate (0 - no limit)
+        static std::int64_t GetInterval(double ratePerSecond)
+        {
+            return ratePerSecond > 0.0 ? std::int64_t(1e9 / ratePerSecond) : 0;
+        }
+
+        /// returns if message may be logged - one message per interval on average, bursts up to burst messages.
+        /// suppressed - count of messages refused since previous allowed one
+        bool Allow(std::int64_t interval, unsigned int burst, std::uint64_t & suppressed)
+        {
+            suppressed = 0;
+
+            if (interval <= 0)
+                return true;
+
+            std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            std::int64_t tolerance = interval * (burst > 1 ? burst - 1 : 0);
+            std::int64_t tat = tat_.load(std::memory_order_relaxed);
+            std::int64_t next;
+
+            do
+            {
+                // bucket empty - refused message only counted
+                if (tat - now > tolerance)
+                {
+                    suppressed_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                next = (tat > now ? tat : now) + interval;
+            }
+            while (!tat_.compare_exchange_weak(tat, next, std::memory_order_relaxed));
+
+            if (suppressed_.load(std::memory_order_relaxed))
+                suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        /// returns table slot of message kind identified by pointer (format string) / text
+        static std::size_t GetSlot(const void * key)
+        {
+            return std::size_t((std::uint64_t(reinterpret_cast<std::uintptr_t>(key)) * 0x9E3779B97F4A7C15ULL) >> 32) & (SLOG_RATE_LIMIT_SLOTS - 1);
+        }
+
+        static std::size_t GetSlot(const char * data, std::size_t size)
+        {
+            // FNV-1a
+            std::uint64_t hash = 0xCBF29CE484222325ULL;
+            for (std::size_t i = 0; i < size; ++i)
+                hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001B3ULL;
+
+            return std::size_t(hash ^ (hash >> 32)) & (SLOG_RATE_LIMIT_SLOTS - 1);
+        }
+
+    private:
+        std::atomic<std::int64_t> tat_;
+        std::atomic<std::uint64_t> suppressed_;
+    };
+}
+
+#endif // SIOF_LOGGER_RATE_LIMIT
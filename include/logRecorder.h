@@ -0,0 +1,89 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_RECORDER
+#define SIOF_LOGGER_RECORDER
+
+#include <cstddef>
+#include <vector>
+
+#include "logConfig.h"
+#include "logMsg.h"
+
+namespace siof
+{
+    /// Ring of last messages kept in memory by logging thread instead of being written (Logger::SetFlightRecorder).
+    /// Messages are copied not yet formatted into slots which keep their buffers - no allocations once
+    /// every slot was used.
+    class LogFlightRecorder
+    {
+    public:
+        LogFlightRecorder() : next_(0), count_(0) {}
+
+        /// changes count of kept messages (kept ones are forgotten)
+        void SetCapacity(std::size_t capacity)
+        {
+            std::vector<LogMsg>(capacity).swap(msgs_);
+            next_ = 0;
+            count_ = 0;
+        }
+
+        std::size_t GetCapacity() const { return msgs_.size(); }
+        std::size_t GetCount() const { return count_; }
+
+        /// keeps copy of message, oldest one is overwritten when ring is full
+        void Add(const LogMsg & msg)
+        {
+            if (msgs_.empty())
+                return;
+
+            msgs_[next_] = msg;
+            next_ = (next_ + 1) % msgs_.size();
+
+            if (count_ < msgs_.size())
+                ++count_;
+        }
+
+        /// calls f for kept messages in order they were added (oldest first)
+        template <typename F>
+        void ForEach(F f)
+        {
+            if (!count_)
+                return;
+
+            std::size_t start = (next_ + msgs_.size() - count_) % msgs_.size();
+
+            for (std::size_t i = 0; i < count_; ++i)
+                f(msgs_[(start + i) % msgs_.size()]);
+        }
+
+        /// forgets kept messages
+        void Clear()
+        {
+            next_ = 0;
+            count_ = 0;
+        }
+
+    private:
+        std::vector<LogMsg> msgs_;
+        /// slot for next message
+        std::size_t next_;
+        std::size_t count_;
+    };
+}
+
+#endif // SIOF_LOGGER_RECORDER
@@ -0,0 +1,170 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_SINK
+#define SIOF_LOGGER_SINK
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logConfig.h"
+#include "logMsg.h"
+
+namespace siof
+{
+    /// default max bytes waiting for sink with own thread (LogAsyncSink), newer lines are dropped above it
+    #define SLOG_ASYNC_SINK_MAX_PENDING     (1024 * 1024)
+
+    /// position of one line in LogRenderedBatch text
+    struct LogRenderedLine
+    {
+        std::size_t begin;
+        /// start of message text (after time and level, line start for logfmt and JSON)
+        std::size_t msgBegin;
+        /// end of line (after '\n')
+        std::size_t end;
+        LogLevel logLevel;
+        /// message time
+        LogTimePoint time;
+    };
+
+    /// Lines of one batch rendered once by logging thread and shared by all sinks
+    class LogRenderedBatch
+    {
+    public:
+        void Clear();
+
+        /// formats message (if needed) and renders it as next line
+        void Add(LogMsg & msg, LogTimeCache & timeCache, LogFormat format = SLOG_FORMAT_TEXT);
+        /// appends copy of line from other batch
+        void Add(const LogRenderedBatch & batch, std::size_t index);
+
+        std::size_t GetCount() const { return lines_.size(); }
+        const std::string & GetText() const { return text_; }
+        const LogRenderedLine & GetLine(std::size_t index) const { return lines_[index]; }
+
+    private:
+        std::string text_;
+        std::vector<LogRenderedLine> lines_;
+    };
+
+    /// Log output. Logging thread calls Write with every rendered batch and then Commit.
+    /// Simple sinks implement WriteData (gets runs of consecutive lines passing level filter),
+    /// sinks which need every line separately override Write.
+    class LogSink
+    {
+    public:
+        LogSink() : logLevel_(SLOG_LEVEL_NONE) {}
+        virtual ~LogSink() {}
+
+        /// lines with lower level are not written to this sink
+        void SetLevel(LogLevel logLevel) { logLevel_ = logLevel; }
+        LogLevel GetLevel() const { return logLevel_.load(std::memory_order_relaxed); }
+        bool Accepts(LogLevel logLevel) const { return GetLevel() <= logLevel; }
+
+        /// writes lines [first, last) of batch which pass level filter
+        virtual void Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last);
+
+        /// called after every batch, force - batch contains message which has to be written at once
+        virtual void Commit(bool force) { (void)force; }
+
+        /// called when logger closes - everything held by sink has to be written
+        virtual void Close() {}
+
+    protected:
+        /// writes whole lines (data is valid only during call)
+        virtual void WriteData(const char * data, std::size_t size) { (void)data; (void)size; }
+
+    private:
+        LogSink(const LogSink &);
+        LogSink & operator = (const LogSink &);
+
+        std::atomic<LogLevel> logLevel_;
+    };
+
+    /// Runs other sink on own thread, so slow output (e.g. blocked pipe) can't stall logging thread.
+    /// Lines are copied to pending batch; when more than maxPending bytes wait, new lines are dropped.
+    class LogAsyncSink : public LogSink
+    {
+    public:
+        explicit LogAsyncSink(const std::shared_ptr<LogSink> & sink, std::size_t maxPending = SLOG_ASYNC_SINK_MAX_PENDING);
+        ~LogAsyncSink();
+
+        void Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last) override;
+        void Commit(bool force) override;
+        /// writes pending lines and stops thread (it's started again by next Write)
+        void Close() override;
+
+        const std::shared_ptr<LogSink> & GetSink() const { return sink_; }
+        /// returns count of lines dropped because sink was behind
+        std::uint64_t GetDropped() const { return dropped_; }
+
+    private:
+        void Run();
+
+        std::shared_ptr<LogSink> sink_;
+        std::size_t maxPending_;
+
+        /// lines waiting for sink thread
+        LogRenderedBatch pending_;
+        /// lines written by sink thread
+        LogRenderedBatch writing_;
+        bool force_;
+        bool closing_;
+        std::atomic<std::uint64_t> dropped_;
+
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        std::shared_ptr<std::thread> thread_;
+    };
+
+    /// Hands every rendered batch to registered sinks
+    class LogDispatcher
+    {
+    public:
+        LogDispatcher() : count_(0) {}
+
+        void Add(const std::shared_ptr<LogSink> & sink);
+        void Remove(const std::shared_ptr<LogSink> & sink);
+
+        /// returns if there is no sink (lines don't have to be rendered for dispatcher)
+        bool IsEmpty() const { return count_ == 0; }
+
+        /// writes batch to all sinks, force - batch has to be written at once
+        void Dispatch(const LogRenderedBatch & batch, bool force);
+
+        /// closes all sinks
+        void Close();
+
+    private:
+        std::vector<std::shared_ptr<LogSink> > sinks_;
+        std::atomic<std::size_t> count_;
+        std::mutex mutex_;
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logSink.cpp"
+#endif
+
+#endif // SIOF_LOGGER_SINK
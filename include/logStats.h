@@ -0,0 +1,178 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_STATS
+#define SIOF_LOGGER_STATS
+
+#include <atomic>
+#include <cstdint>
+
+#include "logConfig.h"
+#include "logMsg.h"
+
+namespace siof
+{
+    /// buckets of LogHistogram - bucket i holds values < 2^i (and >= 2^(i-1)), last one everything above
+    #define SLOG_HISTOGRAM_BUCKETS  40
+
+    /// Counter written by one thread (plain load + store, no locked instruction), read by any
+    class LogCounter
+    {
+    public:
+        LogCounter() : value_(0) {}
+
+        void Add(std::uint64_t value = 1) { value_.store(value_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed); }
+
+        /// keeps max of current and given value
+        void Max(std::uint64_t value)
+        {
+            if (value > value_.load(std::memory_order_relaxed))
+                value_.store(value, std::memory_order_relaxed);
+        }
+
+        std::uint64_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<std::uint64_t> value_;
+    };
+
+    /// copy of LogHistogram counts
+    struct LogHistogramSnapshot
+    {
+        std::uint64_t counts[SLOG_HISTOGRAM_BUCKETS];
+
+        /// returns limit of bucket i (values in bucket are lower)
+        static std::uint64_t GetBucketLimit(int i) { return std::uint64_t(1) << i; }
+
+        std::uint64_t GetCount() const
+        {
+            std::uint64_t count = 0;
+            for (std::uint64_t c : counts)
+                count += c;
+
+            return count;
+        }
+
+        /// returns limit of bucket containing given percentile (0 - 100) of values
+        std::uint64_t GetPercentile(double percentile) const
+        {
+            std::uint64_t count = GetCount();
+            std::uint64_t rank = std::uint64_t(percentile / 100.0 * double(count) + 0.5);
+            std::uint64_t seen = 0;
+
+            for (int i = 0; i < SLOG_HISTOGRAM_BUCKETS; ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank && seen > 0)
+                    return GetBucketLimit(i);
+            }
+
+            return 0;
+        }
+    };
+
+    /// Power of 2 histogram written by one thread, read by any
+    class LogHistogram
+    {
+    public:
+        void Add(std::uint64_t value)
+        {
+            int bucket = 0;
+            while (value && bucket < SLOG_HISTOGRAM_BUCKETS - 1)
+            {
+                value >>= 1;
+                ++bucket;
+            }
+
+            counts_[bucket].Add();
+        }
+
+        void Get(LogHistogramSnapshot & out) const
+        {
+            for (int i = 0; i < SLOG_HISTOGRAM_BUCKETS; ++i)
+                out.counts[i] = counts_[i].Get();
+        }
+
+    private:
+        LogCounter counts_[SLOG_HISTOGRAM_BUCKETS];
+    };
+
+    /// Logger::GetStats snapshot (counters since logger creation, read without stopping anything)
+    struct LogStats
+    {
+        /// messages put into queues
+        std::uint64_t enqueued;
+        /// messages written by logging thread (to file and sinks) per level - collapsed and kept ones and
+        /// "N messages dropped" lines aren't included (logged message is counted once in written, dropped,
+        /// repeats or recorded)
+        std::uint64_t written[SLOG_LEVEL_COUNT];
+        /// messages dropped by overflow policy per level
+        std::uint64_t dropped[SLOG_LEVEL_COUNT];
+        /// bytes written to log file (before compression)
+        std::uint64_t bytesWritten;
+
+        /// messages waiting in queues now / most seen by logging thread
+        std::uint64_t queueDepth;
+        std::uint64_t queueDepthPeak;
+
+        /// batches written by logging thread and their sizes (messages)
+        std::uint64_t batches;
+        LogHistogramSnapshot batchSizes;
+
+        /// parked logging thread woken by producer / by wait timeout
+        std::uint64_t wakeups;
+        std::uint64_t idleTimeouts;
+        /// wake-up signals sent by producers (only parked logging thread is signalled)
+        std::uint64_t signals;
+
+        /// messages refused by rate limits (counted when next message of the kind is logged)
+        std::uint64_t rateLimited;
+        /// messages collapsed into "previous message repeated" lines (not included in written)
+        std::uint64_t repeats;
+        /// messages kept by flight recorder (not included in written, also when trigger level writes them)
+        /// and writes of kept messages by trigger level
+        std::uint64_t recorded;
+        std::uint64_t recorderDumps;
+
+        /// duration of writes of pending data to file (nanoseconds)
+        LogHistogramSnapshot flushLatency;
+
+        /// file (re)opens - rollovers included - and total time spent in them (nanoseconds)
+        std::uint64_t rollovers;
+        std::uint64_t rolloverTime;
+
+        std::uint64_t GetWritten() const
+        {
+            std::uint64_t count = 0;
+            for (std::uint64_t c : written)
+                count += c;
+
+            return count;
+        }
+
+        std::uint64_t GetDropped() const
+        {
+            std::uint64_t count = 0;
+            for (std::uint64_t c : dropped)
+                count += c;
+
+            return count;
+        }
+    };
+}
+
+#endif // SIOF_LOGGER_STATS
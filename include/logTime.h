@@ -0,0 +1,79 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_TIME
+#define SIOF_LOGGER_TIME
+
+#include <chrono>
+#include <ctime>
+
+#include "logConfig.h"
+
+namespace siof
+{
+    typedef std::chrono::time_point<std::chrono::system_clock, std::chrono::system_clock::duration> LogTimePoint;
+
+    /// length of "YYYY-MM-DD HH:MM:SS." part
+    #define SLOG_TIME_SECONDS_SIZE  20
+    /// length of "YYYY-MM-DD HH:MM:SS.mmm"
+    #define SLOG_TIME_SIZE          (SLOG_TIME_SECONDS_SIZE + 3)
+
+    /// thread safe std::localtime replacement
+    bool LocalTime(std::time_t time, std::tm & out);
+
+    /// Keeps rendered "YYYY-MM-DD HH:MM:SS." prefix of last seen second, so
+    /// timezone lookup and formatting is done once per second instead of once per message.
+    /// Not thread safe - every thread should have own cache.
+    class LogTimeCache
+    {
+    public:
+        LogTimeCache() : second_(-1), day_(-1), utcOffset_(0) {}
+
+        /// refreshes cached data if time is from other second than last one
+        void Update(std::time_t second)
+        {
+            if (second != second_)
+                Refresh(second);
+        }
+
+        /// writes SLOG_TIME_SIZE chars ("YYYY-MM-DD HH:MM:SS.mmm") to out (no terminating zero)
+        void Render(const LogTimePoint & time, char * out);
+
+        /// returns local day (year * 1000 + day of year) of last updated second
+        int GetDay() const { return day_; }
+
+        /// returns local time offset from UTC (in seconds) of last updated second
+        long GetUtcOffset() const { return utcOffset_; }
+
+        /// async-signal-safe Render variant (no timezone lookup) - time is shifted by given utcOffset
+        static void RenderSafe(const LogTimePoint & time, long utcOffset, char * out);
+
+    private:
+        void Refresh(std::time_t second);
+
+        std::time_t second_;
+        int day_;
+        long utcOffset_;
+        char prefix_[SLOG_TIME_SECONDS_SIZE];
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logTime.cpp"
+#endif
+
+#endif // SIOF_LOGGER_TIME
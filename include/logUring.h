@@ -0,0 +1,91 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_URING
+#define SIOF_LOGGER_URING
+
+#include <cstddef>
+#include <cstdint>
+
+#include "logConfig.h"
+
+/// SLOG_HAS_IO_URING - build has io_uring support (Linux with kernel headers), availability
+/// is still checked at runtime (old kernel, seccomp, io_uring disabled by sysctl)
+#if !defined(SLOG_HAS_IO_URING) && !defined(SLOG_NO_IO_URING) && defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SLOG_HAS_IO_URING
+#endif
+#endif
+
+namespace siof
+{
+    /// Minimal io_uring (Linux 5.6+) used by logging thread for asynchronous file writes - raw
+    /// syscalls and mapped rings, no liburing needed. Single thread only.
+    class LogUring
+    {
+    public:
+        LogUring();
+        ~LogUring();
+
+        /// creates ring with entries submission slots, returns false if io_uring is not available
+        bool Init(unsigned int entries);
+        void Close();
+        bool IsOpen() const { return fd_ >= 0; }
+
+        /// queues write of size bytes from data at file offset, userData comes back with completion.
+        /// Returns false if submission ring is full. Data has to stay valid until completion.
+        bool Write(int fd, const void * data, std::size_t size, std::uint64_t offset, std::uint64_t userData);
+
+        /// submits queued requests and waits for at least minComplete completions
+        bool Submit(unsigned int minComplete);
+
+        /// takes next completion (result is written bytes or -errno), false if there is none
+        bool Reap(std::uint64_t & userData, int & result);
+
+    private:
+        int fd_;
+
+        void * sqRing_;
+        std::size_t sqRingSize_;
+        void * cqRing_;
+        std::size_t cqRingSize_;
+        /// io_uring_sqe array
+        void * sqes_;
+        std::size_t sqesSize_;
+
+        unsigned int * sqHead_;
+        unsigned int * sqTail_;
+        unsigned int sqMask_;
+        unsigned int sqEntries_;
+        unsigned int * sqArray_;
+
+        unsigned int * cqHead_;
+        unsigned int * cqTail_;
+        unsigned int cqMask_;
+        /// io_uring_cqe array
+        void * cqes_;
+
+        /// queued and not yet submitted requests
+        unsigned int toSubmit_;
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logUring.cpp"
+#endif
+
+#endif // SIOF_LOGGER_URING
@@ -0,0 +1,667 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logArgs.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace siof
+{
+    namespace detail
+    {
+        /// sequential reader of buffer created by LogArgs::Encode
+        class ArgReader
+        {
+        public:
+            ArgReader(const char * data, std::size_t size)
+                : data_(data), end_(data + size), type_(SLOG_ARG_COUNT), raw_(0), str_(nullptr), strSize_(0),
+                  key_(nullptr), keySize_(0) {}
+
+            bool Next()
+            {
+                if (end_ - data_ < 1)
+                    return false;
+
+                type_ = LogArgType(*data_++);
+
+                if (type_ == SLOG_ARG_STRING || type_ == SLOG_ARG_KEY)
+                {
+                    std::uint32_t size = 0;
+                    if (std::size_t(end_ - data_) < sizeof(size))
+                        return false;
+
+                    std::memcpy(&size, data_, sizeof(size));
+                    data_ += sizeof(size);
+
+                    if (std::size_t(end_ - data_) < size)
+                        return false;
+
+                    str_ = data_;
+                    strSize_ = size;
+                    data_ += size;
+                    return true;
+                }
+
+                if (type_ >= SLOG_ARG_COUNT || end_ - data_ < 8)
+                    return false;
+
+                std::memcpy(&raw_, data_, sizeof(raw_));
+                data_ += sizeof(raw_);
+                return true;
+            }
+
+            /// reads next positional argument (fields are skipped)
+            bool NextValue()
+            {
+                while (Next())
+                {
+                    if (type_ != SLOG_ARG_KEY)
+                        return true;
+
+                    if (!Next())
+                        return false;
+                }
+
+                return false;
+            }
+
+            /// reads next field - key is returned by GetKey, value is current argument
+            bool NextField()
+            {
+                while (Next())
+                {
+                    if (type_ != SLOG_ARG_KEY)
+                        continue;
+
+                    key_ = str_;
+                    keySize_ = strSize_;
+                    return Next();
+                }
+
+                return false;
+            }
+
+            LogArgType GetType() const { return type_; }
+
+            std::int64_t GetInt() const
+            {
+                if (type_ == SLOG_ARG_DOUBLE)
+                    return std::int64_t(GetDouble());
+
+                return type_ == SLOG_ARG_STRING ? 0 : std::int64_t(raw_);
+            }
+
+            double GetDouble() const
+            {
+                if (type_ == SLOG_ARG_DOUBLE)
+                {
+                    double value;
+                    std::memcpy(&value, &raw_, sizeof(value));
+                    return value;
+                }
+
+                if (type_ == SLOG_ARG_INT)
+                    return double(std::int64_t(raw_));
+
+                return type_ == SLOG_ARG_STRING ? 0.0 : double(raw_);
+            }
+
+            std::string GetString() const
+            {
+                if (type_ == SLOG_ARG_STRING)
+                    return std::string(str_, strSize_);
+
+                return "(not a string)";
+            }
+
+            const char * GetStr() const { return str_; }
+            std::size_t GetStrSize() const { return strSize_; }
+
+            const char * GetKey() const { return key_; }
+            std::size_t GetKeySize() const { return keySize_; }
+
+        private:
+            const char * data_;
+            const char * end_;
+
+            LogArgType type_;
+            std::uint64_t raw_;
+            const char * str_;
+            std::size_t strSize_;
+            const char * key_;
+            std::size_t keySize_;
+        };
+
+        /// bounded output buffer of LogArgs::FormatSafe
+        class SafeWriter
+        {
+        public:
+            SafeWriter(char * out, std::size_t size) : out_(out), size_(size), pos_(0) {}
+
+            void Put(char c)
+            {
+                if (pos_ < size_)
+                    out_[pos_++] = c;
+            }
+
+            void Put(const char * str, std::size_t size)
+            {
+                for (std::size_t i = 0; i < size; ++i)
+                    Put(str[i]);
+            }
+
+            void PutUnsigned(std::uint64_t value, unsigned int base, bool upper)
+            {
+                const char * digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+                char buffer[24];
+                int count = 0;
+
+                do
+                {
+                    buffer[count++] = digits[value % base];
+                    value /= base;
+                }
+                while (value);
+
+                while (count > 0)
+                    Put(buffer[--count]);
+            }
+
+            void PutSigned(std::int64_t value)
+            {
+                if (value < 0)
+                {
+                    Put('-');
+                    PutUnsigned(std::uint64_t(0) - std::uint64_t(value), 10, false);
+                }
+                else
+                    PutUnsigned(std::uint64_t(value), 10, false);
+            }
+
+            void PutDouble(double value)
+            {
+                if (value != value)
+                {
+                    Put("nan", 3);
+                    return;
+                }
+
+                if (value < 0)
+                {
+                    Put('-');
+                    value = -value;
+                }
+
+                if (value >= 1e19)
+                {
+                    Put("inf", 3);
+                    return;
+                }
+
+                std::uint64_t integral = std::uint64_t(value);
+                std::uint64_t fraction = std::uint64_t((value - double(integral)) * 1e6 + 0.5);
+                if (fraction >= 1000000)
+                {
+                    ++integral;
+                    fraction -= 1000000;
+                }
+
+                PutUnsigned(integral, 10, false);
+                Put('.');
+
+                for (std::uint64_t div = 100000; div > 0; div /= 10)
+                    Put(char('0' + fraction / div % 10));
+            }
+
+            std::size_t GetSize() const { return pos_; }
+
+        private:
+            char * out_;
+            std::size_t size_;
+            std::size_t pos_;
+        };
+
+        /// returns mask with high bit set in every byte of word which is < 0x20, '"' or '\\'
+        /// (bytes above first found one may be marked too - only used to find words needing escape)
+        inline std::uint64_t EscapeMask(std::uint64_t word)
+        {
+            const std::uint64_t ones = 0x0101010101010101ULL;
+            const std::uint64_t highs = 0x8080808080808080ULL;
+
+            std::uint64_t quote = word ^ (ones * '"');
+            std::uint64_t backslash = word ^ (ones * '\\');
+
+            return (((word - ones * 0x20) & ~word) | ((quote - ones) & ~quote) | ((backslash - ones) & ~backslash)) & highs;
+        }
+
+        /// appends double with shortest of %.15g / %.17g which reads back as same value
+        inline void AppendDouble(std::string & out, double value)
+        {
+            char buffer[32];
+            int size = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+
+            if (std::strtod(buffer, nullptr) != value)
+                size = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+
+            out.append(buffer, size);
+        }
+
+        /// appends field key for text and logfmt - characters other than [A-Za-z0-9_.-] are replaced by '_',
+        /// so that key=value pair parses back (key can't be quoted)
+        inline void AppendKey(const char * key, std::size_t size, std::string & out)
+        {
+            if (!size)
+            {
+                out += '_';
+                return;
+            }
+
+            for (const char * end = key + size; key < end; ++key)
+            {
+                char c = *key;
+                bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '-';
+
+                out += valid ? c : '_';
+            }
+        }
+
+        /// appends current argument of reader as field value
+        inline void AppendFieldValue(const ArgReader & reader, LogFormat format, std::string & out)
+        {
+            char buffer[32];
+            int size = 0;
+
+            switch (reader.GetType())
+            {
+                case SLOG_ARG_INT:
+                    size = std::snprintf(buffer, sizeof(buffer), "%lld", (long long)reader.GetInt());
+                    break;
+                case SLOG_ARG_UINT:
+                    size = std::snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)reader.GetInt());
+                    break;
+                case SLOG_ARG_BOOL:
+                    out += reader.GetInt() ? "true" : "false";
+                    return;
+                case SLOG_ARG_DOUBLE:
+                {
+                    double value = reader.GetDouble();
+
+                    // JSON has no nan/inf
+                    if (format == SLOG_FORMAT_JSON && (value != value || value - value != 0.0))
+                        out += "null";
+                    else
+                        AppendDouble(out, value);
+                    return;
+                }
+                case SLOG_ARG_POINTER:
+                    size = std::snprintf(buffer, sizeof(buffer), format == SLOG_FORMAT_JSON ? "\"0x%llx\"" : "0x%llx",
+                                         (unsigned long long)reader.GetInt());
+                    break;
+                case SLOG_ARG_STRING:
+                    if (format == SLOG_FORMAT_JSON)
+                    {
+                        out += '"';
+                        LogArgs::AppendEscaped(reader.GetStr(), reader.GetStrSize(), out);
+                        out += '"';
+                    }
+                    else
+                        LogArgs::AppendLogfmtValue(reader.GetStr(), reader.GetStrSize(), out);
+                    return;
+                default:
+                    return;
+            }
+
+            out.append(buffer, size);
+        }
+
+        /// appends snprintf result for single conversion spec
+        template <typename T>
+        void AppendSpec(std::string & out, const std::string & spec, const int * stars, int starCount, T value)
+        {
+            char buffer[128];
+            int size = 0;
+
+            switch (starCount)
+            {
+                case 0:  size = std::snprintf(buffer, sizeof(buffer), spec.c_str(), value); break;
+                case 1:  size = std::snprintf(buffer, sizeof(buffer), spec.c_str(), stars[0], value); break;
+                default: size = std::snprintf(buffer, sizeof(buffer), spec.c_str(), stars[0], stars[1], value); break;
+            }
+
+            if (size < 0)
+                return;
+
+            if (std::size_t(size) < sizeof(buffer))
+            {
+                out.append(buffer, size);
+                return;
+            }
+
+            std::size_t start = out.size();
+            out.resize(start + size + 1);
+
+            switch (starCount)
+            {
+                case 0:  std::snprintf(&out[start], size + 1, spec.c_str(), value); break;
+                case 1:  std::snprintf(&out[start], size + 1, spec.c_str(), stars[0], value); break;
+                default: std::snprintf(&out[start], size + 1, spec.c_str(), stars[0], stars[1], value); break;
+            }
+
+            out.resize(start + size);
+        }
+    }
+
+    SLOG_INLINE void LogArgs::Format(const char * fmt, const char * args, std::size_t size, std::string & out)
+    {
+        detail::ArgReader reader(args, size);
+        std::string spec;
+
+        while (*fmt)
+        {
+            const char * next = std::strchr(fmt, '%');
+            if (!next)
+            {
+                out.append(fmt);
+                break;
+            }
+
+            out.append(fmt, next - fmt);
+            fmt = next + 1;
+
+            if (*fmt == '%')
+            {
+                out += '%';
+                ++fmt;
+                continue;
+            }
+
+            // spec without length modifiers - they are replaced to match encoded (widened) values
+            spec.assign(1, '%');
+            int stars[2];
+            int starCount = 0;
+            bool valid = true;
+
+            while (*fmt && std::strchr("-+ #0'", *fmt))
+                spec += *fmt++;
+
+            while (*fmt && (*fmt == '*' || *fmt == '.' || (*fmt >= '0' && *fmt <= '9')))
+            {
+                if (*fmt == '*')
+                {
+                    if (starCount < 2 && reader.NextValue())
+                        stars[starCount++] = int(reader.GetInt());
+                    else
+                        valid = false;
+                }
+
+                spec += *fmt++;
+            }
+
+            while (*fmt && std::strchr("hlLqjzt", *fmt))
+                ++fmt;
+
+            char conversion = *fmt;
+            if (!conversion)
+                break;
+
+            ++fmt;
+
+            if (!valid || !reader.NextValue())
+            {
+                out += "(missing)";
+                continue;
+            }
+
+            switch (conversion)
+            {
+                case 'd':
+                case 'i':
+                    spec += "ll";
+                    spec += conversion;
+                    detail::AppendSpec(out, spec, stars, starCount, (long long)reader.GetInt());
+                    break;
+                case 'o':
+                case 'u':
+                case 'x':
+                case 'X':
+                    spec += "ll";
+                    spec += conversion;
+                    detail::AppendSpec(out, spec, stars, starCount, (unsigned long long)reader.GetInt());
+                    break;
+                case 'c':
+                    spec += conversion;
+                    detail::AppendSpec(out, spec, stars, starCount, int(reader.GetInt()));
+                    break;
+                case 'e':
+                case 'E':
+                case 'f':
+                case 'F':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                    spec += conversion;
+                    detail::AppendSpec(out, spec, stars, starCount, reader.GetDouble());
+                    break;
+                case 's':
+                    // plain %s is most common - no need to call snprintf
+                    if (spec.size() == 1 && reader.GetType() == SLOG_ARG_STRING)
+                        out.append(reader.GetStr(), reader.GetStrSize());
+                    else
+                    {
+                        spec += conversion;
+                        detail::AppendSpec(out, spec, stars, starCount, reader.GetString().c_str());
+                    }
+                    break;
+                case 'p':
+                    spec += conversion;
+                    detail::AppendSpec(out, spec, stars, starCount, reinterpret_cast<void *>(std::uintptr_t(reader.GetInt())));
+                    break;
+                default:
+                    // %n and unknown conversions are not supported
+                    break;
+            }
+        }
+    }
+
+    SLOG_INLINE std::size_t LogArgs::FormatSafe(const char * fmt, const char * args, std::size_t size, char * out, std::size_t outSize)
+    {
+        detail::ArgReader reader(args, size);
+        detail::SafeWriter writer(out, outSize);
+
+        while (*fmt)
+        {
+            if (*fmt != '%')
+            {
+                writer.Put(*fmt++);
+                continue;
+            }
+
+            ++fmt;
+
+            if (*fmt == '%')
+            {
+                writer.Put(*fmt++);
+                continue;
+            }
+
+            bool valid = true;
+
+            while (*fmt && std::strchr("-+ #0'", *fmt))
+                ++fmt;
+
+            while (*fmt && (*fmt == '*' || *fmt == '.' || (*fmt >= '0' && *fmt <= '9')))
+            {
+                // star takes argument
+                if (*fmt == '*' && !reader.NextValue())
+                    valid = false;
+
+                ++fmt;
+            }
+
+            while (*fmt && std::strchr("hlLqjzt", *fmt))
+                ++fmt;
+
+            char conversion = *fmt;
+            if (!conversion)
+                break;
+
+            ++fmt;
+
+            if (!valid || !reader.NextValue())
+            {
+                writer.Put("(missing)", 9);
+                continue;
+            }
+
+            switch (conversion)
+            {
+                case 'd':
+                case 'i':
+                    writer.PutSigned(reader.GetInt());
+                    break;
+                case 'u':
+                    writer.PutUnsigned(std::uint64_t(reader.GetInt()), 10, false);
+                    break;
+                case 'o':
+                    writer.PutUnsigned(std::uint64_t(reader.GetInt()), 8, false);
+                    break;
+                case 'x':
+                case 'X':
+                    writer.PutUnsigned(std::uint64_t(reader.GetInt()), 16, conversion == 'X');
+                    break;
+                case 'p':
+                    writer.Put("0x", 2);
+                    writer.PutUnsigned(std::uint64_t(reader.GetInt()), 16, false);
+                    break;
+                case 'c':
+                    writer.Put(char(reader.GetInt()));
+                    break;
+                case 'e':
+                case 'E':
+                case 'f':
+                case 'F':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                    writer.PutDouble(reader.GetDouble());
+                    break;
+                case 's':
+                    if (reader.GetType() == SLOG_ARG_STRING)
+                        writer.Put(reader.GetStr(), reader.GetStrSize());
+                    else
+                        writer.Put("(not a string)", 14);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        return writer.GetSize();
+    }
+
+    SLOG_INLINE void LogArgs::FormatFields(const char * args, std::size_t size, LogFormat format, std::string & out)
+    {
+        detail::ArgReader reader(args, size);
+
+        while (reader.NextField())
+        {
+            if (format == SLOG_FORMAT_JSON)
+            {
+                out += ",\"";
+                AppendEscaped(reader.GetKey(), reader.GetKeySize(), out);
+                out += "\":";
+            }
+            else
+            {
+                out += ' ';
+                detail::AppendKey(reader.GetKey(), reader.GetKeySize(), out);
+                out += '=';
+            }
+
+            detail::AppendFieldValue(reader, format, out);
+        }
+    }
+
+    SLOG_INLINE void LogArgs::AppendEscaped(const char * data, std::size_t size, std::string & out)
+    {
+        static const char hex[] = "0123456789abcdef";
+
+        const char * end = data + size;
+
+        while (data < end)
+        {
+            // copy clean run - 8 bytes are checked at once
+            const char * run = data;
+
+            while (end - data >= 8)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, data, sizeof(word));
+
+                if (detail::EscapeMask(word))
+                    break;
+
+                data += 8;
+            }
+
+            while (data < end && static_cast<unsigned char>(*data) >= 0x20 && *data != '"' && *data != '\\')
+                ++data;
+
+            out.append(run, data - run);
+
+            if (data == end)
+                break;
+
+            char c = *data++;
+
+            switch (c)
+            {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    out += "\\u00";
+                    out += hex[(c >> 4) & 0x0F];
+                    out += hex[c & 0x0F];
+                    break;
+            }
+        }
+    }
+
+    SLOG_INLINE void LogArgs::AppendLogfmtValue(const char * data, std::size_t size, std::string & out)
+    {
+        bool quote = size == 0;
+
+        for (std::size_t i = 0; i < size && !quote; ++i)
+            quote = static_cast<unsigned char>(data[i]) <= ' ' || data[i] == '=' || data[i] == '"' || data[i] == '\\';
+
+        if (!quote)
+        {
+            out.append(data, size);
+            return;
+        }
+
+        out += '"';
+        AppendEscaped(data, size, out);
+        out += '"';
+    }
+}
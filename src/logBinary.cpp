@@ -0,0 +1,433 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logBinary.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace siof
+{
+    namespace detail
+    {
+        SLOG_INLINE void PutVarint(std::string & out, std::uint64_t value)
+        {
+            char buffer[10];
+            int size = 0;
+
+            while (value >= 0x80)
+            {
+                buffer[size++] = char(value | 0x80);
+                value >>= 7;
+            }
+
+            buffer[size++] = char(value);
+            out.append(buffer, size);
+        }
+
+        SLOG_INLINE std::uint64_t ZigZag(std::int64_t value)
+        {
+            return (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63);
+        }
+
+        SLOG_INLINE std::int64_t UnZigZag(std::uint64_t value)
+        {
+            return std::int64_t(value >> 1) ^ -std::int64_t(value & 1);
+        }
+
+        SLOG_INLINE std::int64_t ToNanoseconds(const LogTimePoint & time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        /// LogArgs encoding -> packed args (varint integers)
+        SLOG_INLINE void PackArgs(const std::string & args, std::string & out)
+        {
+            const char * data = args.data();
+            const char * end = data + args.size();
+
+            while (data < end)
+            {
+                char type = *data++;
+                out += type;
+
+                if (type == SLOG_ARG_STRING || type == SLOG_ARG_KEY)
+                {
+                    std::uint32_t size;
+                    std::memcpy(&size, data, sizeof(size));
+                    data += sizeof(size);
+
+                    PutVarint(out, size);
+                    out.append(data, size);
+                    data += size;
+                    continue;
+                }
+
+                std::uint64_t raw;
+                std::memcpy(&raw, data, sizeof(raw));
+                data += sizeof(raw);
+
+                if (type == SLOG_ARG_INT)
+                    PutVarint(out, ZigZag(std::int64_t(raw)));
+                else if (type == SLOG_ARG_DOUBLE)
+                    out.append(reinterpret_cast<const char *>(&raw), sizeof(raw));
+                else
+                    PutVarint(out, raw);
+            }
+        }
+
+        /// sequential reader of packed data held in memory
+        class PackedReader
+        {
+        public:
+            PackedReader(const char * data, std::size_t size) : data_(data), end_(data + size) {}
+
+            bool AtEnd() const { return data_ >= end_; }
+
+            bool Byte(char & value)
+            {
+                if (data_ >= end_)
+                    return false;
+
+                value = *data_++;
+                return true;
+            }
+
+            bool Varint(std::uint64_t & value)
+            {
+                value = 0;
+                for (int shift = 0; shift < 64 && data_ < end_; shift += 7)
+                {
+                    unsigned char byte = static_cast<unsigned char>(*data_++);
+                    value |= std::uint64_t(byte & 0x7F) << shift;
+
+                    if (!(byte & 0x80))
+                        return true;
+                }
+
+                return false;
+            }
+
+            bool Bytes(std::string & out, std::uint64_t size)
+            {
+                if (std::uint64_t(end_ - data_) < size)
+                    return false;
+
+                out.append(data_, std::size_t(size));
+                data_ += size;
+                return true;
+            }
+
+        private:
+            const char * data_;
+            const char * end_;
+        };
+
+        /// packed args -> LogArgs encoding
+        SLOG_INLINE bool UnpackArgs(const std::string & packed, std::string & out)
+        {
+            PackedReader reader(packed.data(), packed.size());
+
+            while (!reader.AtEnd())
+            {
+                char type;
+                std::uint64_t value;
+                if (!reader.Byte(type))
+                    return false;
+
+                out += type;
+
+                switch (type)
+                {
+                    case SLOG_ARG_STRING:
+                    case SLOG_ARG_KEY:
+                    {
+                        if (!reader.Varint(value) || value > UINT32_MAX)
+                            return false;
+
+                        std::uint32_t size = std::uint32_t(value);
+                        out.append(reinterpret_cast<const char *>(&size), sizeof(size));
+                        if (!reader.Bytes(out, size))
+                            return false;
+                        break;
+                    }
+                    case SLOG_ARG_DOUBLE:
+                        if (!reader.Bytes(out, sizeof(double)))
+                            return false;
+                        break;
+                    case SLOG_ARG_INT:
+                    case SLOG_ARG_UINT:
+                    case SLOG_ARG_POINTER:
+                    case SLOG_ARG_BOOL:
+                        if (!reader.Varint(value))
+                            return false;
+
+                        if (type == SLOG_ARG_INT)
+                            value = std::uint64_t(UnZigZag(value));
+
+                        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+                        break;
+                    default:
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// sequential reader of binary log stream
+        class StreamReader
+        {
+        public:
+            explicit StreamReader(std::istream & in) : in_(in) {}
+
+            bool Byte(char & value)
+            {
+                return bool(in_.get(value));
+            }
+
+            bool Varint(std::uint64_t & value)
+            {
+                value = 0;
+                char byte;
+
+                for (int shift = 0; shift < 64 && in_.get(byte); shift += 7)
+                {
+                    value |= std::uint64_t(static_cast<unsigned char>(byte) & 0x7F) << shift;
+
+                    if (!(byte & 0x80))
+                        return true;
+                }
+
+                return false;
+            }
+
+            bool Bytes(std::string & out, std::uint64_t size)
+            {
+                out.clear();
+
+                while (out.size() < size)
+                {
+                    std::size_t pos = out.size();
+                    std::size_t chunk = std::size_t(std::min<std::uint64_t>(size - pos, SLOG_BINARY_READ_CHUNK));
+
+                    out.resize(pos + chunk);
+                    if (!in_.read(&out[pos], std::streamsize(chunk)))
+                        return false;
+                }
+
+                return true;
+            }
+
+        private:
+            std::istream & in_;
+        };
+    }
+
+    SLOG_INLINE void LogBinaryEncoder::StartSession(std::string & out, const std::string & separator)
+    {
+        formats_.clear();
+        categories_.clear();
+        lastTime_ = detail::ToNanoseconds(std::chrono::system_clock::now());
+
+        out += char(SLOG_BIN_SESSION);
+        out.append(SLOG_BINARY_MAGIC, SLOG_BINARY_MAGIC_SIZE);
+        detail::PutVarint(out, detail::ZigZag(lastTime_));
+        detail::PutVarint(out, separator.size());
+        out += separator;
+        out += SLOG_BINARY_RECORD_END;
+    }
+
+    SLOG_INLINE void LogBinaryEncoder::Encode(const LogMsg & msg, std::string & out)
+    {
+        const char * fmt = msg.GetFormat();
+        std::uint32_t formatId = 0;
+
+        packed_.clear();
+
+        if (fmt)
+        {
+            formatId = Intern(formats_, SLOG_BIN_FORMAT, fmt, out);
+            detail::PackArgs(msg.GetArgs(), packed_);
+        }
+        else
+        {
+            // ready text is stored as single string arg
+            packed_ += char(SLOG_ARG_STRING);
+            detail::PutVarint(packed_, msg.GetMsg().size());
+            packed_ += msg.GetMsg();
+        }
+
+        std::int64_t time = detail::ToNanoseconds(msg.GetTime());
+
+        if (msg.GetCategory())
+        {
+            std::uint32_t categoryId = Intern(categories_, SLOG_BIN_CATEGORY, msg.GetCategory(), out);
+
+            out += char(SLOG_BIN_CATEGORY_MSG);
+            detail::PutVarint(out, categoryId);
+        }
+        else
+            out += char(SLOG_BIN_MSG);
+
+        detail::PutVarint(out, detail::ZigZag(time - lastTime_));
+        out += char(msg.GetLogLevel());
+        detail::PutVarint(out, formatId);
+        detail::PutVarint(out, packed_.size());
+        out += packed_;
+        out += SLOG_BINARY_RECORD_END;
+
+        lastTime_ = time;
+    }
+
+    SLOG_INLINE std::uint32_t LogBinaryEncoder::Intern(StringIds & ids, LogBinaryRecord type, const char * str, std::string & out)
+    {
+        auto itr = ids.find(str);
+        if (itr != ids.end())
+            return itr->second;
+
+        std::uint32_t id = std::uint32_t(ids.size() + 1);
+        ids[str] = id;
+
+        std::size_t size = std::strlen(str);
+
+        out += char(type);
+        detail::PutVarint(out, id);
+        detail::PutVarint(out, size);
+        out.append(str, size);
+        out += SLOG_BINARY_RECORD_END;
+
+        return id;
+    }
+
+    SLOG_INLINE bool LogBinaryDecoder::Decode(std::istream & in, std::ostream & out, LogFormat format)
+    {
+        detail::StreamReader reader(in);
+
+        std::vector<std::string> formats;
+        std::vector<std::string> categories;
+        std::int64_t lastTime = 0;
+        LogTimeCache timeCache;
+        LogMsg msg;
+        std::string tmpStr, packed, args, line;
+
+        char type;
+        while (reader.Byte(type))
+        {
+            std::uint64_t value = 0;
+
+            switch (type)
+            {
+                case SLOG_BIN_SESSION:
+                {
+                    if (!reader.Bytes(tmpStr, SLOG_BINARY_MAGIC_SIZE) || tmpStr != SLOG_BINARY_MAGIC)
+                        return false;
+
+                    if (!reader.Varint(value))
+                        return false;
+
+                    lastTime = detail::UnZigZag(value);
+                    formats.clear();
+                    categories.clear();
+
+                    if (!reader.Varint(value) || !reader.Bytes(tmpStr, value))
+                        return false;
+
+                    // separator would break JSON Lines / logfmt stream
+                    if (format == SLOG_FORMAT_TEXT)
+                        out << "\n" << tmpStr << "\n\n";
+                    break;
+                }
+                case SLOG_BIN_FORMAT:
+                case SLOG_BIN_CATEGORY:
+                {
+                    std::vector<std::string> & strings = type == SLOG_BIN_FORMAT ? formats : categories;
+
+                    // ids are given in sequence (from 1 in every session) - anything else is corrupted
+                    std::uint64_t id;
+                    if (!reader.Varint(id) || id == 0 || id > std::max<std::size_t>(strings.size(), 1))
+                        return false;
+
+                    if (!reader.Varint(value) || !reader.Bytes(tmpStr, value))
+                        return false;
+
+                    if (strings.size() <= id)
+                        strings.resize(std::size_t(id) + 1);
+
+                    strings[std::size_t(id)] = tmpStr;
+                    break;
+                }
+                case SLOG_BIN_MSG:
+                case SLOG_BIN_CATEGORY_MSG:
+                {
+                    char logLevel;
+                    std::uint64_t formatId;
+                    std::uint64_t categoryId = 0;
+
+                    if (type == SLOG_BIN_CATEGORY_MSG && (!reader.Varint(categoryId) || categoryId == 0 || categoryId >= categories.size()))
+                        return false;
+
+                    if (!reader.Varint(value) || !reader.Byte(logLevel) || !reader.Varint(formatId))
+                        return false;
+
+                    if (logLevel < 0 || logLevel >= SLOG_LEVEL_COUNT)
+                        return false;
+
+                    lastTime += detail::UnZigZag(value);
+
+                    if (!reader.Varint(value) || !reader.Bytes(packed, value))
+                        return false;
+
+                    args.clear();
+                    if (!detail::UnpackArgs(packed, args))
+                        return false;
+
+                    const char * fmt = "%s";
+                    if (formatId != 0)
+                    {
+                        if (formatId >= formats.size())
+                            return false;
+
+                        fmt = formats[std::size_t(formatId)].c_str();
+                    }
+
+                    msg.SetEncoded(LogLevel(logLevel), fmt, args);
+                    msg.SetCategory(categoryId ? categories[std::size_t(categoryId)].c_str() : nullptr);
+                    msg.SetTime(LogTimePoint(std::chrono::duration_cast<LogTimePoint::duration>(std::chrono::nanoseconds(lastTime))));
+                    msg.Format();
+
+                    line.clear();
+                    msg.Render(line, timeCache, format);
+                    out.write(line.data(), line.size());
+                    break;
+                }
+                case 0:
+                    // zero filled tail of file left by crashed process (mapped mode)
+                    return true;
+                default:
+                    return false;
+            }
+
+            char end;
+            if (!reader.Byte(end) || end != SLOG_BINARY_RECORD_END)
+                return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,104 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logCategory.h"
+
+namespace siof
+{
+    SLOG_INLINE LogCategory::LogCategory(const std::string & name, LogCategory * parent) : name_(name), parent_(parent),
+        level_(parent ? parent->GetLevel() : SLOG_LEVEL_NONE), ownLevel_(SLOG_LEVEL_COUNT)
+    {
+    }
+
+    SLOG_INLINE LogCategories::LogCategories(LogLevel rootLevel) : root_("", nullptr)
+    {
+        root_.ownLevel_ = rootLevel;
+        root_.level_ = rootLevel;
+    }
+
+    SLOG_INLINE LogCategory & LogCategories::Get(const std::string & name)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        return GetLocked(name);
+    }
+
+    SLOG_INLINE LogCategory & LogCategories::GetLocked(const std::string & name)
+    {
+        if (name.empty())
+            return root_;
+
+        auto itr = categories_.find(name);
+        if (itr != categories_.end())
+            return *itr->second;
+
+        std::size_t pos = name.rfind(SLOG_CATEGORY_SEPARATOR);
+        LogCategory & parent = pos == std::string::npos ? root_ : GetLocked(name.substr(0, pos));
+
+        std::shared_ptr<LogCategory> category(new LogCategory(name, &parent));
+        categories_[name] = category;
+
+        return *category;
+    }
+
+    SLOG_INLINE void LogCategories::SetLevel(const std::string & name, LogLevel logLevel)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        GetLocked(name).ownLevel_ = logLevel;
+        Update(name);
+    }
+
+    SLOG_INLINE void LogCategories::ResetLevel(const std::string & name)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        // root has always own level
+        if (name.empty())
+            return;
+
+        GetLocked(name).ownLevel_ = SLOG_LEVEL_COUNT;
+        Update(name);
+    }
+
+    SLOG_INLINE void LogCategories::SetRootLevel(LogLevel logLevel)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        root_.ownLevel_ = logLevel;
+        Update("");
+    }
+
+    SLOG_INLINE void LogCategories::Update(const std::string & name)
+    {
+        auto apply = [] (LogCategory & category) -> void
+        {
+            category.level_ = category.ownLevel_ != SLOG_LEVEL_COUNT ? category.ownLevel_ : category.parent_->GetLevel();
+        };
+
+        if (name.empty())
+            root_.level_ = root_.ownLevel_;
+        else
+            apply(*categories_.find(name)->second);
+
+        // every name sorts after its prefix, so parents are updated before their subcategories
+        std::string prefix = name.empty() ? name : name + SLOG_CATEGORY_SEPARATOR;
+
+        for (auto itr = categories_.lower_bound(prefix); itr != categories_.end() && itr->first.compare(0, prefix.size(), prefix) == 0; ++itr)
+            apply(*itr->second);
+    }
+}
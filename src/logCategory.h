@@ -0,0 +1,98 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_CATEGORY
+#define SIOF_LOGGER_CATEGORY
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "logConfig.h"
+#include "logMsg.h"
+
+namespace siof
+{
+    /// separates levels of category name ("net.http" is subcategory of "net")
+    #define SLOG_CATEGORY_SEPARATOR     '.'
+
+    /// Named log category handle - get it once (LogCategories::Get / Logger::GetCategory) and keep it
+    /// at call site, level check is single relaxed load. Handle lives as long as its registry.
+    class LogCategory
+    {
+    public:
+        const std::string & GetName() const { return name_; }
+
+        /// returns if message with given level passes category level
+        bool IsLevelEnabled(LogLevel logLevel) const
+        {
+            return level_.load(std::memory_order_relaxed) <= logLevel;
+        }
+
+        /// returns effective minimal level (own or inherited)
+        LogLevel GetLevel() const { return level_.load(std::memory_order_relaxed); }
+
+    private:
+        friend class LogCategories;
+
+        LogCategory(const std::string & name, LogCategory * parent);
+
+        std::string name_;
+        LogCategory * parent_;
+        std::atomic<LogLevel> level_;
+        /// level set for this category (SLOG_LEVEL_COUNT - inherited from parent), under registry mutex
+        LogLevel ownLevel_;
+    };
+
+    /// Hierarchy of categories - category without own level inherits level of its parent,
+    /// top level categories inherit root level
+    class LogCategories
+    {
+    public:
+        explicit LogCategories(LogLevel rootLevel = SLOG_LEVEL_NONE);
+
+        /// returns category (created with its parents when needed)
+        LogCategory & Get(const std::string & name);
+
+        /// sets minimal level of category and all its subcategories without own level
+        void SetLevel(const std::string & name, LogLevel logLevel);
+        /// category inherits level of its parent again
+        void ResetLevel(const std::string & name);
+
+        /// sets level inherited by top level categories
+        void SetRootLevel(LogLevel logLevel);
+
+    private:
+        /// returns category, caller holds mutex_
+        LogCategory & GetLocked(const std::string & name);
+        /// updates effective levels of category and its subcategories
+        void Update(const std::string & name);
+
+        LogCategory root_;
+        /// sorted by name, so every parent is before its subcategories
+        std::map<std::string, std::shared_ptr<LogCategory> > categories_;
+        std::mutex mutex_;
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logCategory.cpp"
+#endif
+
+#endif // SIOF_LOGGER_CATEGORY
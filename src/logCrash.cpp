@@ -0,0 +1,172 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logCrash.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+
+#include "logger.h"
+
+namespace siof
+{
+    namespace detail
+    {
+        /// signals handled by LogCrashHandler
+        inline const int * GetCrashSignals(std::size_t & count)
+        {
+#ifdef _WIN32
+            static const int signals[] = { SIGSEGV, SIGILL, SIGFPE, SIGABRT };
+#else
+            static const int signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+#endif
+            count = sizeof(signals) / sizeof(signals[0]);
+            return signals;
+        }
+
+        struct CrashState
+        {
+            CrashState() : installed(false), handling(false)
+            {
+                for (auto & p : loggers)
+                    p = nullptr;
+            }
+
+            /// registered loggers (null - free place), read by signal handler without locking
+            std::atomic<Logger *> loggers[SLOG_CRASH_MAX_LOGGERS];
+            /// serializes Register/Unregister/Install
+            std::mutex mutex;
+            bool installed;
+            /// set by first crashing thread
+            std::atomic<bool> handling;
+#ifdef _WIN32
+            void (*oldHandlers[8])(int);
+#else
+            struct sigaction oldActions[8];
+#endif
+        };
+
+        inline CrashState & GetCrashState()
+        {
+            static CrashState state;
+            return state;
+        }
+    }
+
+    SLOG_INLINE bool LogCrashHandler::Register(Logger * logger)
+    {
+        detail::CrashState & state = detail::GetCrashState();
+        std::lock_guard<std::mutex> guard(state.mutex);
+
+        if (!state.installed && !Install())
+            return false;
+
+        for (auto & p : state.loggers)
+        {
+            if (p.load() == nullptr)
+            {
+                p = logger;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    SLOG_INLINE void LogCrashHandler::Unregister(Logger * logger)
+    {
+        detail::CrashState & state = detail::GetCrashState();
+        std::lock_guard<std::mutex> guard(state.mutex);
+
+        for (auto & p : state.loggers)
+            if (p.load() == logger)
+                p = nullptr;
+    }
+
+    SLOG_INLINE bool LogCrashHandler::Install()
+    {
+        detail::CrashState & state = detail::GetCrashState();
+
+        std::size_t count = 0;
+        const int * signals = detail::GetCrashSignals(count);
+
+#ifdef _WIN32
+        for (std::size_t i = 0; i < count; ++i)
+            state.oldHandlers[i] = signal(signals[i], &LogCrashHandler::Handle);
+#else
+        // handler of stack overflow needs own stack (only for installing thread, usually main one)
+        static char altStack[SLOG_CRASH_STACK_SIZE];
+
+        stack_t stack;
+        memset(&stack, 0, sizeof(stack));
+        stack.ss_sp = altStack;
+        stack.ss_size = sizeof(altStack);
+        sigaltstack(&stack, nullptr);
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = &LogCrashHandler::Handle;
+        action.sa_flags = SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (sigaction(signals[i], &action, &state.oldActions[i]) != 0)
+                return false;
+        }
+#endif
+
+        state.installed = true;
+        return true;
+    }
+
+    SLOG_INLINE void LogCrashHandler::Handle(int signalNumber)
+    {
+        detail::CrashState & state = detail::GetCrashState();
+
+        // other threads crashing at the same time only pass signal on
+        if (!state.handling.exchange(true))
+        {
+            for (auto & p : state.loggers)
+            {
+                Logger * logger = p.load();
+                if (logger)
+                    logger->WriteOnCrash();
+            }
+        }
+
+        std::size_t count = 0;
+        const int * signals = detail::GetCrashSignals(count);
+
+        // restore previous handler (default one terminates process) and raise signal again
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (signals[i] != signalNumber)
+                continue;
+
+#ifdef _WIN32
+            signal(signalNumber, state.oldHandlers[i]);
+#else
+            sigaction(signalNumber, &state.oldActions[i], nullptr);
+#endif
+        }
+
+        raise(signalNumber);
+    }
+}
@@ -0,0 +1,56 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_CRASH
+#define SIOF_LOGGER_CRASH
+
+#include "logConfig.h"
+
+namespace siof
+{
+    /// max loggers with enabled crash handler
+    #define SLOG_CRASH_MAX_LOGGERS  8
+    /// max length of queued message written by crash handler (longer ones are cut)
+    #define SLOG_CRASH_LINE_SIZE    4096
+    /// size of alternate signal stack (so stack overflow can be handled too)
+    #define SLOG_CRASH_STACK_SIZE   (64 * 1024)
+    /// max wait (in milliseconds) for logging thread to stop before crash handler writes (nothing is written if it doesn't)
+    #define SLOG_CRASH_WRITER_WAIT  100
+
+    class Logger;
+
+    /// Fatal signal handler (SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT) which writes everything
+    /// registered loggers hold in memory to their files and then passes signal to previous handler.
+    /// Installed with first registered logger and kept installed.
+    class LogCrashHandler
+    {
+    public:
+        /// returns false if there are too many loggers or handler can't be installed
+        static bool Register(Logger * logger);
+        static void Unregister(Logger * logger);
+
+    private:
+        static bool Install();
+        static void Handle(int signalNumber);
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logCrash.cpp"
+#endif
+
+#endif // SIOF_LOGGER_CRASH
@@ -0,0 +1,846 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logFileSink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef SLOG_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef SLOG_HAS_IO_URING
+#include <cstdlib>
+#endif
+
+namespace siof
+{
+    namespace detail
+    {
+        SLOG_INLINE int OpenAppend(const std::string & path)
+        {
+#ifdef _WIN32
+            return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+            return open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+        }
+
+        SLOG_INLINE void CloseFd(int fd)
+        {
+#ifdef _WIN32
+            _close(fd);
+#else
+            close(fd);
+#endif
+        }
+
+        /// writes whole data (retries on partial writes and signals)
+        SLOG_INLINE std::size_t WriteAll(int fd, const char * data, std::size_t size)
+        {
+            std::size_t done = 0;
+
+            while (done < size)
+            {
+#ifdef _WIN32
+                int written = _write(fd, data + done, static_cast<unsigned int>(size - done));
+#else
+                ssize_t written = write(fd, data + done, size - done);
+#endif
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    break;
+                }
+
+                done += std::size_t(written);
+            }
+
+            return done;
+        }
+
+#ifndef _WIN32
+        /// returns end of last non zero byte - file left by crashed process can have zero filled tail
+        SLOG_INLINE std::uint64_t GetDataEnd(int fd, std::uint64_t size)
+        {
+            char block[4096];
+            while (size > 0)
+            {
+                std::size_t part = std::size_t(std::min<std::uint64_t>(size, sizeof(block)));
+                if (pread(fd, block, part, off_t(size - part)) != ssize_t(part))
+                    break;
+
+                std::size_t i = part;
+                while (i > 0 && block[i - 1] == 0)
+                    --i;
+
+                size -= part - i;
+                if (i > 0)
+                    break;
+            }
+
+            return size;
+        }
+#endif
+    }
+
+    SLOG_INLINE LogFileSink::LogFileSink() : fd_(-1), size_(0), mapped_(false), mappedNext_(false), map_(nullptr), mapOffset_(0), mapSize_(0),
+        dataEnd_(0), compressed_(false), compressedNext_(false), compressionLevel_(SLOG_COMPRESSION_LEVEL_DEFAULT),
+        zstream_(nullptr), async_(false), asyncNext_(false), direct_(false), directNext_(false), asyncIndex_(0),
+        indexedNext_(false), flushBytes_(SLOG_FLUSH_BYTES_DEFAULT), flushInterval_(SLOG_FLUSH_INTERVAL_DEFAULT), pending_(false)
+    {
+        buffer_.reserve(flushBytes_ * 2);
+
+        for (AsyncBuffer & buffer : asyncBuffers_)
+        {
+            buffer.data = nullptr;
+            buffer.capacity = 0;
+            buffer.size = 0;
+            buffer.offset = 0;
+            buffer.busy = false;
+        }
+    }
+
+    SLOG_INLINE LogFileSink::~LogFileSink()
+    {
+        Close();
+
+#ifdef SLOG_WITH_ZLIB
+        if (zstream_)
+        {
+            deflateEnd(static_cast<z_stream *>(zstream_));
+            delete static_cast<z_stream *>(zstream_);
+        }
+#endif
+
+        // closed ring has no writes in flight
+        uring_.Close();
+
+#ifdef SLOG_HAS_IO_URING
+        for (AsyncBuffer & buffer : asyncBuffers_)
+            free(buffer.data);
+#endif
+    }
+
+    SLOG_INLINE bool LogFileSink::Open(const std::string & path)
+    {
+        Close();
+
+        if (!OpenFile(path))
+            return false;
+
+        // offsets of compressed file don't point to lines
+        if (indexedNext_ && !compressed_)
+            index_.Open(path + SLOG_INDEX_EXTENSION);
+
+        return true;
+    }
+
+    SLOG_INLINE bool LogFileSink::OpenFile(const std::string & path)
+    {
+        compressed_ = compressedNext_;
+        mapped_ = mappedNext_ && !compressed_;
+        if (mapped_)
+            return OpenMapped(path);
+
+        // ring is created once and kept for next files
+        async_ = asyncNext_ && !compressed_ && (uring_.IsOpen() || uring_.Init(SLOG_ASYNC_BUFFERS * 2));
+        if (async_)
+            return OpenAsync(path);
+
+        fd_ = detail::OpenAppend(path);
+        if (fd_ < 0)
+            return false;
+
+        struct stat st;
+        size_ = fstat(fd_, &st) == 0 ? std::uint64_t(st.st_size) : 0;
+
+        return true;
+    }
+
+    SLOG_INLINE void LogFileSink::Close()
+    {
+        Flush();
+
+        if (mapped_)
+            CloseMapped();
+
+        if (async_)
+            CloseAsync();
+
+        index_.Close();
+
+        if (fd_ >= 0)
+            detail::CloseFd(fd_);
+
+        fd_ = -1;
+        size_ = 0;
+    }
+
+    SLOG_INLINE bool LogFileSink::IsOpen() const
+    {
+        return fd_ >= 0;
+    }
+
+    SLOG_INLINE void LogFileSink::Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last)
+    {
+        std::size_t begin = buffer_.size();
+
+        LogSink::Write(batch, first, last);
+
+        if (!index_.IsOpen() || buffer_.size() == begin)
+            return;
+
+        std::int64_t minTime = INT64_MAX;
+        std::int64_t maxTime = INT64_MIN;
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const LogRenderedLine & line = batch.GetLine(i);
+
+            if (!Accepts(line.logLevel))
+                continue;
+
+            std::int64_t time = LogIndexWriter::GetTime(line.time);
+            minTime = std::min(minTime, time);
+            maxTime = std::max(maxTime, time);
+        }
+
+        // file offset is known once pending data is written
+        LogIndexRecord record;
+        record.offset = begin;
+        record.size = buffer_.size() - begin;
+        record.minTime = minTime;
+        record.maxTime = maxTime;
+        pendingIndex_.push_back(record);
+    }
+
+    SLOG_INLINE void LogFileSink::Commit(bool force)
+    {
+        if (buffer_.empty())
+            return;
+
+        auto now = std::chrono::steady_clock::now();
+
+        if (!pending_)
+        {
+            pending_ = true;
+            pendingSince_ = now;
+        }
+
+        // copying to mapping costs no syscall - do it at once
+        if (mapped_ || force || buffer_.size() >= flushBytes_ || now - pendingSince_ >= flushInterval_)
+            Flush();
+    }
+
+    SLOG_INLINE void LogFileSink::Flush()
+    {
+        if (fd_ >= 0 && !buffer_.empty())
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::uint64_t offset = size_;
+
+            writtenBytes_.Add(buffer_.size());
+
+            // latency of asynchronous write is measured when it finishes
+            if (async_)
+                WriteAsync(buffer_.data(), buffer_.size());
+            else
+            {
+                if (compressed_)
+                    WriteCompressed(buffer_.data(), buffer_.size());
+                else if (mapped_)
+                    CopyToMap(buffer_.data(), buffer_.size());
+                else
+                    size_ += detail::WriteAll(fd_, buffer_.data(), buffer_.size());
+
+                flushLatency_.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            }
+
+            // only lines which are whole in file are indexed
+            std::uint64_t written = size_ - offset;
+            for (const LogIndexRecord & record : pendingIndex_)
+            {
+                if (record.offset + record.size > written)
+                    break;
+
+                index_.Add(offset + record.offset, record.size, record.minTime, record.maxTime);
+            }
+        }
+
+        buffer_.clear();
+        pendingIndex_.clear();
+        pending_ = false;
+    }
+
+    SLOG_INLINE void LogFileSink::Sync()
+    {
+        Flush();
+
+        if (fd_ < 0)
+            return;
+
+        if (async_)
+        {
+            WaitAsync();
+            WriteDirectTail();
+        }
+
+#ifdef _WIN32
+        _commit(fd_);
+#else
+        if (mapped_ && map_ && dataEnd_ > mapOffset_)
+            msync(map_, std::size_t(dataEnd_ - mapOffset_), MS_SYNC);
+#ifdef __APPLE__
+        fsync(fd_);
+#else
+        fdatasync(fd_);
+#endif
+#endif
+    }
+
+    SLOG_INLINE void LogFileSink::EmergencyWrite(const char * data, std::size_t size)
+    {
+        if (fd_ < 0 || compressed_ || size == 0)
+            return;
+
+#ifndef _WIN32
+        // mapped file has zero filled tail - write right after data (zeros are cut on next open anyway)
+        if (mapped_)
+        {
+            if (pwrite(fd_, data, size, off_t(dataEnd_)) == ssize_t(size))
+                dataEnd_ += size;
+
+            return;
+        }
+
+#ifdef SLOG_HAS_IO_URING
+        // file is not opened for appending - write after all submitted data
+        if (async_)
+        {
+            if (direct_)
+            {
+                // O_DIRECT needs aligned data - crash lines go through page cache, after kept partial block
+                fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT);
+                direct_ = false;
+
+                if (!directTail_.empty())
+                    pwrite(fd_, directTail_.data(), directTail_.size(), off_t(size_ - directTail_.size()));
+
+                directTail_.clear();
+            }
+
+            if (pwrite(fd_, data, size, off_t(size_)) == ssize_t(size))
+                size_ += size;
+
+            return;
+        }
+#endif
+#endif
+
+        detail::WriteAll(fd_, data, size);
+    }
+
+    SLOG_INLINE void LogFileSink::EmergencyFlush()
+    {
+        if (async_)
+        {
+            // let submitted writes finish before crashed process exits
+            unsigned int busy = 0;
+            for (const AsyncBuffer & buffer : asyncBuffers_)
+                busy += buffer.busy ? 1 : 0;
+
+            if (busy)
+                uring_.Submit(busy);
+        }
+
+        EmergencyWrite(buffer_.data(), buffer_.size());
+    }
+
+    SLOG_INLINE void LogFileSink::ReallocateBuffers()
+    {
+        // copy keeps pending data
+        std::string(buffer_).swap(buffer_);
+        std::string().swap(compressedBuffer_);
+
+#ifdef SLOG_HAS_IO_URING
+        // asynchronous buffers are allocated again on next write
+        for (AsyncBuffer & buffer : asyncBuffers_)
+        {
+            if (!buffer.busy)
+            {
+                free(buffer.data);
+                buffer.data = nullptr;
+                buffer.capacity = 0;
+            }
+        }
+#endif
+    }
+
+    SLOG_INLINE void LogFileSink::SetFlushPolicy(std::size_t bytes, unsigned int intervalMs)
+    {
+        flushBytes_ = bytes;
+        flushInterval_ = std::chrono::milliseconds(intervalMs);
+
+        if (buffer_.capacity() < flushBytes_ * 2)
+            buffer_.reserve(flushBytes_ * 2);
+    }
+
+    SLOG_INLINE void LogFileSink::SetMapped(bool mapped)
+    {
+#ifdef _WIN32
+        // not supported - plain writes are used
+        (void)mapped;
+#else
+        mappedNext_ = mapped;
+#endif
+    }
+
+    SLOG_INLINE void LogFileSink::SetCompressed(bool compressed, int level)
+    {
+        compressedNext_ = compressed && CanCompress();
+
+#ifdef SLOG_WITH_ZLIB
+        // stream is created again with new level on next write
+        if (zstream_ && level != compressionLevel_)
+        {
+            deflateEnd(static_cast<z_stream *>(zstream_));
+            delete static_cast<z_stream *>(zstream_);
+            zstream_ = nullptr;
+        }
+#endif
+
+        compressionLevel_ = level;
+    }
+
+    SLOG_INLINE void LogFileSink::SetAsync(bool async, bool direct)
+    {
+#ifdef SLOG_HAS_IO_URING
+        asyncNext_ = async;
+        directNext_ = async && direct;
+#else
+        // not supported - plain writes are used
+        (void)async;
+        (void)direct;
+#endif
+    }
+
+    SLOG_INLINE bool LogFileSink::CanCompress()
+    {
+#ifdef SLOG_WITH_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    SLOG_INLINE void LogFileSink::WriteCompressed(const char * data, std::size_t size)
+    {
+#ifdef SLOG_WITH_ZLIB
+        z_stream * stream = static_cast<z_stream *>(zstream_);
+
+        if (!stream)
+        {
+            stream = new z_stream;
+            std::memset(stream, 0, sizeof(z_stream));
+
+            // 15 + 16 - max window with gzip header
+            if (deflateInit2(stream, compressionLevel_, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                delete stream;
+                return;
+            }
+
+            zstream_ = stream;
+        }
+        else
+            deflateReset(stream);
+
+        compressedBuffer_.resize(deflateBound(stream, uLong(size)));
+
+        stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream->avail_in = uInt(size);
+        stream->next_out = reinterpret_cast<Bytef *>(&compressedBuffer_[0]);
+        stream->avail_out = uInt(compressedBuffer_.size());
+
+        if (deflate(stream, Z_FINISH) != Z_STREAM_END)
+            return;
+
+        std::size_t compressedSize = compressedBuffer_.size() - stream->avail_out;
+        size_ += detail::WriteAll(fd_, compressedBuffer_.data(), compressedSize);
+#else
+        size_ += detail::WriteAll(fd_, data, size);
+#endif
+    }
+
+#ifdef _WIN32
+    SLOG_INLINE bool LogFileSink::OpenMapped(const std::string &) { return false; }
+    SLOG_INLINE bool LogFileSink::Remap() { return false; }
+    SLOG_INLINE void LogFileSink::CopyToMap(const char *, std::size_t) {}
+    SLOG_INLINE void LogFileSink::CloseMapped() {}
+#else
+    SLOG_INLINE bool LogFileSink::OpenMapped(const std::string & path)
+    {
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd_, &st) != 0)
+        {
+            detail::CloseFd(fd_);
+            fd_ = -1;
+            return false;
+        }
+
+        // continue after last data byte
+        dataEnd_ = detail::GetDataEnd(fd_, std::uint64_t(st.st_size));
+
+        if (!Remap())
+        {
+            Close();
+            return false;
+        }
+
+        size_ = dataEnd_;
+        return true;
+    }
+
+    SLOG_INLINE bool LogFileSink::Remap()
+    {
+        if (map_)
+            munmap(map_, mapSize_);
+
+        map_ = nullptr;
+
+        std::uint64_t page = std::uint64_t(sysconf(_SC_PAGESIZE));
+        mapOffset_ = dataEnd_ - dataEnd_ % page;
+        mapSize_ = SLOG_MMAP_CHUNK;
+
+        if (ftruncate(fd_, off_t(mapOffset_ + mapSize_)) != 0)
+            return false;
+
+        void * tmpMap = mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, off_t(mapOffset_));
+        if (tmpMap == MAP_FAILED)
+            return false;
+
+        map_ = static_cast<char *>(tmpMap);
+        return true;
+    }
+
+    SLOG_INLINE void LogFileSink::CopyToMap(const char * data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            if (!map_ || dataEnd_ == mapOffset_ + mapSize_)
+            {
+                if (!Remap())
+                {
+                    // can't grow mapping - write rest normally
+                    ssize_t written = pwrite(fd_, data, size, off_t(dataEnd_));
+                    if (written > 0)
+                        dataEnd_ += std::uint64_t(written);
+
+                    size_ = dataEnd_;
+                    return;
+                }
+            }
+
+            std::size_t part = std::min<std::size_t>(size, std::size_t(mapOffset_ + mapSize_ - dataEnd_));
+            std::memcpy(map_ + (dataEnd_ - mapOffset_), data, part);
+
+            dataEnd_ += part;
+            data += part;
+            size -= part;
+        }
+
+        size_ = dataEnd_;
+    }
+
+    SLOG_INLINE void LogFileSink::CloseMapped()
+    {
+        if (map_)
+            munmap(map_, mapSize_);
+
+        map_ = nullptr;
+        mapSize_ = 0;
+
+        if (fd_ >= 0)
+            while (ftruncate(fd_, off_t(dataEnd_)) != 0 && errno == EINTR) {}
+    }
+#endif
+
+#ifndef SLOG_HAS_IO_URING
+    SLOG_INLINE bool LogFileSink::OpenAsync(const std::string &) { return false; }
+    SLOG_INLINE void LogFileSink::WriteAsync(const char *, std::size_t) {}
+    SLOG_INLINE bool LogFileSink::ReapAsync(bool) { return false; }
+    SLOG_INLINE void LogFileSink::WaitAsync() {}
+    SLOG_INLINE void LogFileSink::WriteDirectTail() {}
+    SLOG_INLINE void LogFileSink::CloseAsync() {}
+    SLOG_INLINE void LogFileSink::WriteAt(const char *, std::size_t, std::uint64_t) {}
+    SLOG_INLINE bool LogFileSink::ReserveAsync(AsyncBuffer &, std::size_t) { return false; }
+#else
+    SLOG_INLINE bool LogFileSink::OpenAsync(const std::string & path)
+    {
+        // writes have explicit offsets - O_APPEND would reorder writes finished out of order
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd_, &st) != 0)
+        {
+            detail::CloseFd(fd_);
+            fd_ = -1;
+            return false;
+        }
+
+        size_ = std::uint64_t(st.st_size);
+
+        // padded last block left by crashed process - continue after last data byte
+        if (directNext_)
+            size_ = detail::GetDataEnd(fd_, size_);
+
+        if (size_ != std::uint64_t(st.st_size))
+            while (ftruncate(fd_, off_t(size_)) != 0 && errno == EINTR) {}
+
+        directTail_.clear();
+        asyncIndex_ = 0;
+
+        // file system without O_DIRECT support (e.g. tmpfs) - page cache is used
+        direct_ = directNext_ && fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_DIRECT) == 0;
+
+        // partial last block is written again together with next data
+        if (direct_ && size_ % SLOG_DIRECT_ALIGN)
+        {
+            AsyncBuffer & buffer = asyncBuffers_[asyncIndex_];
+            std::uint64_t offset = size_ - size_ % SLOG_DIRECT_ALIGN;
+
+            if (!ReserveAsync(buffer, SLOG_DIRECT_ALIGN) || pread(fd_, buffer.data, SLOG_DIRECT_ALIGN, off_t(offset)) != ssize_t(size_ - offset))
+            {
+                fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT);
+                direct_ = false;
+            }
+            else
+                directTail_.assign(buffer.data, std::size_t(size_ - offset));
+        }
+
+        return true;
+    }
+
+    SLOG_INLINE void LogFileSink::WriteAsync(const char * data, std::size_t size)
+    {
+        AsyncBuffer & buffer = asyncBuffers_[asyncIndex_];
+
+        // all buffers in flight - disk is slower than logging, wait for oldest write
+        while (buffer.busy && ReapAsync(true)) {}
+
+        std::size_t tail = directTail_.size();
+        std::size_t total = tail + size;
+        // direct mode writes whole blocks only - rest waits for next flush
+        std::size_t writeSize = direct_ ? total - total % SLOG_DIRECT_ALIGN : total;
+        std::uint64_t offset = size_ - tail;
+
+        size_ += size;
+
+        if (writeSize == 0)
+        {
+            directTail_.append(data, size);
+            return;
+        }
+
+        if (buffer.busy || !ReserveAsync(buffer, writeSize))
+        {
+            // ring failed or out of memory - write synchronously and leave O_DIRECT
+            WriteAt(directTail_.data(), tail, offset);
+            WriteAt(data, size, offset + tail);
+            directTail_.clear();
+
+            if (direct_)
+            {
+                fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT);
+                direct_ = false;
+            }
+
+            return;
+        }
+
+        std::memcpy(buffer.data, directTail_.data(), tail);
+        std::memcpy(buffer.data + tail, data, writeSize - tail);
+        directTail_.assign(data + (writeSize - tail), total - writeSize);
+
+        buffer.size = writeSize;
+        buffer.offset = offset;
+        buffer.start = std::chrono::steady_clock::now();
+        buffer.busy = true;
+
+        // ring has more entries than buffers - place for write is expected, not submitted one goes with next Submit
+        if (!uring_.Write(fd_, buffer.data, buffer.size, buffer.offset, asyncIndex_))
+        {
+            // not queued - written synchronously, buffer would stay busy forever
+            WriteAt(buffer.data, buffer.size, buffer.offset);
+            buffer.busy = false;
+            return;
+        }
+
+        uring_.Submit(0);
+
+        asyncIndex_ = (asyncIndex_ + 1) % SLOG_ASYNC_BUFFERS;
+
+        // handle writes finished meanwhile (no syscall)
+        ReapAsync(false);
+    }
+
+    SLOG_INLINE bool LogFileSink::ReapAsync(bool wait)
+    {
+        if (wait && !uring_.Submit(1))
+            return false;
+
+        std::uint64_t index = 0;
+        int result = 0;
+
+        while (uring_.Reap(index, result))
+        {
+            if (index >= SLOG_ASYNC_BUFFERS)
+                continue;
+
+            AsyncBuffer & buffer = asyncBuffers_[index];
+
+            // failed or short write - rest is written synchronously
+            std::size_t done = result > 0 ? std::size_t(result) : 0;
+            if (done < buffer.size)
+                WriteAt(buffer.data + done, buffer.size - done, buffer.offset + done);
+
+            flushLatency_.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - buffer.start).count());
+            buffer.busy = false;
+        }
+
+        return true;
+    }
+
+    SLOG_INLINE void LogFileSink::WaitAsync()
+    {
+        for (AsyncBuffer & buffer : asyncBuffers_)
+        {
+            while (buffer.busy)
+            {
+                if (!ReapAsync(true))
+                {
+                    // ring failed - completion won't come, data is written synchronously
+                    // (same data at same offset if the write was done after all)
+                    WriteAt(buffer.data, buffer.size, buffer.offset);
+                    buffer.busy = false;
+                }
+            }
+        }
+    }
+
+    SLOG_INLINE void LogFileSink::WriteDirectTail()
+    {
+        if (directTail_.empty())
+            return;
+
+        // all writes are finished - any buffer can be used
+        AsyncBuffer & buffer = asyncBuffers_[asyncIndex_];
+        std::uint64_t offset = size_ - directTail_.size();
+
+        // O_DIRECT was left meanwhile - kept data is written as it is
+        if (!direct_ || !ReserveAsync(buffer, SLOG_DIRECT_ALIGN))
+        {
+            WriteAt(directTail_.data(), directTail_.size(), offset);
+            directTail_.clear();
+            return;
+        }
+
+        std::memcpy(buffer.data, directTail_.data(), directTail_.size());
+        std::memset(buffer.data + directTail_.size(), 0, SLOG_DIRECT_ALIGN - directTail_.size());
+        WriteAt(buffer.data, SLOG_DIRECT_ALIGN, offset);
+    }
+
+    SLOG_INLINE void LogFileSink::CloseAsync()
+    {
+        WaitAsync();
+
+        if (fd_ >= 0 && !directTail_.empty())
+        {
+            // padding of last block is cut
+            WriteDirectTail();
+            while (ftruncate(fd_, off_t(size_)) != 0 && errno == EINTR) {}
+        }
+
+        directTail_.clear();
+    }
+
+    SLOG_INLINE void LogFileSink::WriteAt(const char * data, std::size_t size, std::uint64_t offset)
+    {
+        while (size > 0)
+        {
+            ssize_t written = pwrite(fd_, data, size, off_t(offset));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                // unaligned data can't be written with O_DIRECT
+                if (errno == EINVAL && direct_ && fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT) == 0)
+                {
+                    direct_ = false;
+                    continue;
+                }
+
+                return;
+            }
+
+            data += written;
+            offset += std::uint64_t(written);
+            size -= std::size_t(written);
+        }
+    }
+
+    SLOG_INLINE bool LogFileSink::ReserveAsync(AsyncBuffer & buffer, std::size_t size)
+    {
+        if (buffer.capacity >= size)
+            return true;
+
+        // whole blocks - O_DIRECT writes of padded tail stay inside buffer
+        std::size_t capacity = std::max(size, flushBytes_ * 2);
+        capacity += (SLOG_DIRECT_ALIGN - capacity % SLOG_DIRECT_ALIGN) % SLOG_DIRECT_ALIGN;
+
+        void * data = nullptr;
+        if (posix_memalign(&data, SLOG_DIRECT_ALIGN, capacity) != 0)
+            return false;
+
+        free(buffer.data);
+        buffer.data = static_cast<char *>(data);
+        buffer.capacity = capacity;
+        return true;
+    }
+#endif
+}
@@ -0,0 +1,240 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_FILE_SINK
+#define SIOF_LOGGER_FILE_SINK
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "logConfig.h"
+#include "logIndex.h"
+#include "logSink.h"
+#include "logStats.h"
+#include "logUring.h"
+
+namespace siof
+{
+    /// default count of pending bytes which forces write
+    #define SLOG_FLUSH_BYTES_DEFAULT        (64 * 1024)
+    /// default max time (in milliseconds) data can wait in buffer
+    #define SLOG_FLUSH_INTERVAL_DEFAULT     100
+    /// size of file part mapped at once in mapped mode
+    #define SLOG_MMAP_CHUNK                 (16 * 1024 * 1024)
+    /// zlib level used for compressed files (fast - it runs on logging thread)
+    #define SLOG_COMPRESSION_LEVEL_DEFAULT  1
+    /// count of buffers being written at once in asynchronous mode (triple buffering)
+    #define SLOG_ASYNC_BUFFERS              3
+    /// alignment of O_DIRECT writes (buffer address, file offset and size)
+    #define SLOG_DIRECT_ALIGN               4096
+
+    namespace detail
+    {
+        /// writes whole data to descriptor (retries on partial writes and signals), returns written bytes
+        /// (less than size on error)
+        std::size_t WriteAll(int fd, const char * data, std::size_t size);
+    }
+
+    /// Log file written with plain write(2) calls. Lines (LogSink::Write) or binary records
+    /// (appended directly to GetBuffer) wait in pending buffer and are written with single call
+    /// when flush policy says so.
+    /// In mapped mode (POSIX only) file is grown by SLOG_MMAP_CHUNK, mapped and pending data
+    /// is copied to mapping on every Commit - no syscalls and still crash safe (page cache).
+    /// File is truncated to real data size on Close.
+    /// In compressed mode (needs SLOG_WITH_ZLIB) every flush is written as separate gzip member,
+    /// so file is always valid gzip and crash loses at most last unflushed block.
+    /// In asynchronous mode (Linux io_uring) flush copies pending data to one of SLOG_ASYNC_BUFFERS
+    /// buffers and submits write without waiting - logging thread blocks only when all buffers are
+    /// still being written. With O_DIRECT only whole SLOG_DIRECT_ALIGN blocks are written, last partial
+    /// block is kept in memory and written (zero padded) by Sync and Close.
+    /// Indexed file gets sidecar time index (see LogIndexWriter) of lines given to Write.
+    class LogFileSink : public LogSink
+    {
+    public:
+        LogFileSink();
+        ~LogFileSink();
+
+        /// opens file for appending (closes previous one)
+        bool Open(const std::string & path);
+        /// writes pending data and closes file
+        void Close() override;
+        bool IsOpen() const;
+
+        /// appends rendered lines to pending data (and adds them to index)
+        void Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last) override;
+
+        /// returns size of opened file (without pending data)
+        std::uint64_t GetSize() const { return size_; }
+
+        /// pending data - append rendered lines here and call Commit
+        std::string & GetBuffer() { return buffer_; }
+
+        /// writes pending data if force is set, or there are at least flush bytes
+        /// pending, or data waits longer than flush interval
+        void Commit(bool force) override;
+
+        /// writes pending data now
+        void Flush();
+
+        /// returns if committed data waits for flush interval, deadline - when Commit writes it
+        bool GetFlushDeadline(std::chrono::steady_clock::time_point & deadline) const
+        {
+            if (!pending_ || buffer_.empty())
+                return false;
+
+            deadline = pendingSince_ + flushInterval_;
+            return true;
+        }
+
+        /// writes pending data and waits until file data is on disk
+        void Sync();
+
+        /// async-signal-safe write of data after file content (crash handler), pending data
+        /// is not touched. Does nothing for compressed file.
+        void EmergencyWrite(const char * data, std::size_t size);
+        /// writes pending data with EmergencyWrite
+        void EmergencyFlush();
+
+        /// moves buffers to memory allocated by calling thread (logging thread with local NUMA memory policy)
+        void ReallocateBuffers();
+
+        /// returns bytes written to files (before compression) and duration of writes in nanoseconds
+        std::uint64_t GetWrittenBytes() const { return writtenBytes_.Get(); }
+        const LogHistogram & GetFlushLatency() const { return flushLatency_; }
+
+        /// sets flush thresholds (0 interval means flush on every Commit)
+        void SetFlushPolicy(std::size_t bytes, unsigned int intervalMs);
+
+        /// enables mapped mode for files opened from now on
+        void SetMapped(bool mapped);
+
+        /// enables gzip compression for files opened from now on (ignored without SLOG_WITH_ZLIB).
+        /// Compressed files are written without mapping.
+        void SetCompressed(bool compressed, int level = SLOG_COMPRESSION_LEVEL_DEFAULT);
+
+        /// enables asynchronous io_uring writes for files opened from now on (plain writes are used when
+        /// io_uring is not available), direct opens them with O_DIRECT (ignored when file system can't do it).
+        /// Compressed and mapped files are written without io_uring.
+        void SetAsync(bool async, bool direct = false);
+
+        /// returns if opened file is written with io_uring
+        bool IsAsync() const { return async_; }
+
+        /// enables sidecar time index ("<file>.idx") for files opened from now on (not for compressed files)
+        void SetIndexed(bool indexed) { indexedNext_ = indexed; }
+
+        /// returns if compression is available in this build
+        static bool CanCompress();
+
+    protected:
+        /// appends rendered lines to pending data
+        void WriteData(const char * data, std::size_t size) override { buffer_.append(data, size); }
+
+    private:
+        /// opens file in mode selected for next files
+        bool OpenFile(const std::string & path);
+
+        /// mapped mode helpers
+        bool OpenMapped(const std::string & path);
+        bool Remap();
+        void CopyToMap(const char * data, std::size_t size);
+        void CloseMapped();
+
+        /// writes data as gzip member to file
+        void WriteCompressed(const char * data, std::size_t size);
+
+        /// buffer of one asynchronous write (aligned for O_DIRECT)
+        struct AsyncBuffer
+        {
+            char * data;
+            std::size_t capacity;
+            std::size_t size;
+            std::uint64_t offset;
+            std::chrono::steady_clock::time_point start;
+            bool busy;
+        };
+
+        /// asynchronous mode helpers
+        bool OpenAsync(const std::string & path);
+        void WriteAsync(const char * data, std::size_t size);
+        /// handles finished writes, waits for one first if wait is set (false if ring failed)
+        bool ReapAsync(bool wait);
+        /// waits until all submitted writes are finished
+        void WaitAsync();
+        /// writes kept partial block padded with zeros (direct mode)
+        void WriteDirectTail();
+        void CloseAsync();
+        /// synchronous write at offset (switches file from O_DIRECT to page cache when data is not aligned)
+        void WriteAt(const char * data, std::size_t size, std::uint64_t offset);
+        bool ReserveAsync(AsyncBuffer & buffer, std::size_t size);
+
+        int fd_;
+        std::string buffer_;
+        /// bytes in file
+        std::uint64_t size_;
+
+        bool mapped_;
+        bool mappedNext_;
+        char * map_;
+        /// file offset of map_ beginning
+        std::uint64_t mapOffset_;
+        std::size_t mapSize_;
+        /// end of real data in file
+        std::uint64_t dataEnd_;
+
+        bool compressed_;
+        bool compressedNext_;
+        int compressionLevel_;
+        /// z_stream (kept opaque - zlib.h is needed only in sink code)
+        void * zstream_;
+        std::string compressedBuffer_;
+
+        bool async_;
+        bool asyncNext_;
+        bool direct_;
+        bool directNext_;
+        LogUring uring_;
+        AsyncBuffer asyncBuffers_[SLOG_ASYNC_BUFFERS];
+        /// buffer used by next write (buffers are used round robin)
+        std::size_t asyncIndex_;
+        /// direct mode: data of last partial block (file offset aligned, written again with next data)
+        std::string directTail_;
+
+        bool indexedNext_;
+        LogIndexWriter index_;
+        /// index records of lines in buffer_ (offset in buffer) - added to index_ once written
+        std::vector<LogIndexRecord> pendingIndex_;
+
+        std::size_t flushBytes_;
+        std::chrono::milliseconds flushInterval_;
+        /// when buffer_ stopped being empty
+        std::chrono::steady_clock::time_point pendingSince_;
+
+        LogCounter writtenBytes_;
+        LogHistogram flushLatency_;
+        bool pending_;
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logFileSink.cpp"
+#endif
+
+#endif // SIOF_LOGGER_FILE_SINK
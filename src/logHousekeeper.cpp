@@ -0,0 +1,307 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logHousekeeper.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "logIndex.h"
+#include "logThread.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+namespace siof
+{
+    namespace detail
+    {
+        struct LogFileInfo
+        {
+            std::string path;
+            std::string name;
+            std::uint64_t size;
+        };
+
+        /// compares names with digit runs taken as numbers (app_2026_10_18_9 < app_2026_10_18_10)
+        SLOG_INLINE bool NaturalLess(const std::string & a, const std::string & b)
+        {
+            std::size_t i = 0;
+            std::size_t j = 0;
+
+            while (i < a.size() && j < b.size())
+            {
+                if (isdigit(static_cast<unsigned char>(a[i])) && isdigit(static_cast<unsigned char>(b[j])))
+                {
+                    std::size_t startA = i;
+                    std::size_t startB = j;
+
+                    while (i < a.size() && isdigit(static_cast<unsigned char>(a[i])))
+                        ++i;
+                    while (j < b.size() && isdigit(static_cast<unsigned char>(b[j])))
+                        ++j;
+
+                    unsigned long long numA = std::strtoull(a.substr(startA, i - startA).c_str(), nullptr, 10);
+                    unsigned long long numB = std::strtoull(b.substr(startB, j - startB).c_str(), nullptr, 10);
+
+                    if (numA != numB)
+                        return numA < numB;
+
+                    continue;
+                }
+
+                if (a[i] != b[j])
+                    return a[i] < b[j];
+
+                ++i;
+                ++j;
+            }
+
+            return a.size() - i < b.size() - j;
+        }
+
+        /// skips count (or more if atLeast) digits at pos, returns false if there are less
+        SLOG_INLINE bool SkipDigits(const std::string & name, std::size_t & pos, std::size_t count, bool atLeast)
+        {
+            std::size_t start = pos;
+            while (pos < name.size() && isdigit(static_cast<unsigned char>(name[pos])) && (atLeast || pos - start < count))
+                ++pos;
+
+            return pos - start >= count;
+        }
+
+        /// returns if name is <prefix>YYYY_MM_DD[_N].<extension>[.gz] (names given by Logger to its files)
+        SLOG_INLINE bool IsLogFileName(const std::string & name, const std::string & prefix, const std::string & extension)
+        {
+            if (name.compare(0, prefix.size(), prefix) != 0)
+                return false;
+
+            std::size_t pos = prefix.size();
+            if (!SkipDigits(name, pos, 4, false) || name.compare(pos, 1, "_") != 0 ||
+                !SkipDigits(name, ++pos, 2, false) || name.compare(pos, 1, "_") != 0 ||
+                !SkipDigits(name, ++pos, 2, false))
+                return false;
+
+            // part number
+            if (name.compare(pos, 1, "_") == 0 && !SkipDigits(name, ++pos, 1, true))
+                return false;
+
+            std::string suffix = name.substr(pos);
+            return suffix == "." + extension || suffix == "." + extension + ".gz";
+        }
+
+        /// lists log files of prefix (<name>_) and extension in dir
+        SLOG_INLINE void ListLogFiles(const std::string & dir, const std::string & prefix, const std::string & extension,
+                                      std::vector<LogFileInfo> & out)
+        {
+            std::vector<std::string> names;
+
+#ifdef _WIN32
+            struct _finddata_t data;
+            intptr_t handle = _findfirst((dir + "\\*").c_str(), &data);
+            if (handle == -1)
+                return;
+
+            do
+                names.push_back(data.name);
+            while (_findnext(handle, &data) == 0);
+
+            _findclose(handle);
+#else
+            DIR * dirHandle = opendir(dir.c_str());
+            if (!dirHandle)
+                return;
+
+            while (struct dirent * entry = readdir(dirHandle))
+                names.push_back(entry->d_name);
+
+            closedir(dirHandle);
+#endif
+
+            for (auto & name : names)
+            {
+                // other loggers' files (e.g. <name>_2_YYYY_MM_DD.<ext>) and sidecar indexes stay
+                if (!IsLogFileName(name, prefix, extension))
+                    continue;
+
+                LogFileInfo info;
+                info.name = name;
+                info.path = dir + "/" + name;
+
+                struct stat st;
+                if (stat(info.path.c_str(), &st) != 0)
+                    continue;
+
+                info.size = std::uint64_t(st.st_size);
+                out.push_back(info);
+            }
+        }
+    }
+
+    SLOG_INLINE LogHousekeeper::~LogHousekeeper()
+    {
+        Stop();
+    }
+
+    SLOG_INLINE void LogHousekeeper::SetRetention(std::size_t maxFiles, std::uint64_t maxBytes)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        maxFiles_ = maxFiles;
+        maxBytes_ = maxBytes;
+    }
+
+    SLOG_INLINE bool LogHousekeeper::IsEnabled() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        return maxFiles_ != 0 || maxBytes_ != 0;
+    }
+
+    SLOG_INLINE void LogHousekeeper::Notify(const std::string & fileName, const std::string & extension, const std::string & activeFile)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        if (maxFiles_ == 0 && maxBytes_ == 0)
+            return;
+
+        fileName_ = fileName;
+        extension_ = extension;
+        activeFile_ = activeFile;
+        pending_ = true;
+
+        if (!thread_)
+        {
+            closing_ = false;
+            thread_ = std::shared_ptr<std::thread>(new std::thread(&LogHousekeeper::Run, this));
+        }
+
+        cond_.notify_one();
+    }
+
+    SLOG_INLINE void LogHousekeeper::Stop()
+    {
+        std::shared_ptr<std::thread> tmpThread;
+
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            closing_ = true;
+            tmpThread.swap(thread_);
+            cond_.notify_one();
+        }
+
+        if (tmpThread && tmpThread->joinable())
+            tmpThread->join();
+    }
+
+    SLOG_INLINE void LogHousekeeper::Run()
+    {
+        SetCurrentThreadName(SLOG_HOUSEKEEPER_THREAD_NAME);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (true)
+        {
+            cond_.wait(lock, [this] () -> bool { return pending_ || closing_; });
+
+            if (pending_)
+            {
+                std::string fileName = fileName_;
+                std::string extension = extension_;
+                std::string activeFile = activeFile_;
+                std::size_t maxFiles = maxFiles_;
+                std::uint64_t maxBytes = maxBytes_;
+                pending_ = false;
+
+                lock.unlock();
+                Cleanup(fileName, extension, activeFile, maxFiles, maxBytes);
+                lock.lock();
+
+                continue;
+            }
+
+            if (closing_)
+                return;
+        }
+    }
+
+    SLOG_INLINE void LogHousekeeper::Cleanup(const std::string & fileName, const std::string & extension, const std::string & activeFile,
+                                             std::size_t maxFiles, std::uint64_t maxBytes)
+    {
+        std::string dir = ".";
+        std::string prefix = fileName;
+
+        std::size_t sep = fileName.find_last_of("/\\");
+        if (sep != std::string::npos)
+        {
+            dir = fileName.substr(0, sep);
+            prefix = fileName.substr(sep + 1);
+        }
+
+        prefix += '_';
+
+        std::size_t activeSep = activeFile.find_last_of("/\\");
+        std::string activeName = activeSep == std::string::npos ? activeFile : activeFile.substr(activeSep + 1);
+
+        std::vector<detail::LogFileInfo> files;
+        // sidecar indexes are not listed - they are removed with their log files
+        detail::ListLogFiles(dir, prefix, extension, files);
+
+        std::size_t count = 0;
+        std::uint64_t total = 0;
+        for (auto & info : files)
+        {
+            ++count;
+            total += info.size;
+        }
+
+        // active file stays - remove it from candidates, but keep it in limits
+        files.erase(std::remove_if(files.begin(), files.end(), [&activeName] (const detail::LogFileInfo & info) -> bool
+                                    {
+                                        return info.name == activeName;
+                                    }), files.end());
+
+        // oldest first - date and part number are in the name
+        std::sort(files.begin(), files.end(), [] (const detail::LogFileInfo & a, const detail::LogFileInfo & b) -> bool
+                    {
+                        return detail::NaturalLess(a.name, b.name);
+                    });
+
+        for (auto & info : files)
+        {
+            if ((maxFiles == 0 || count <= maxFiles) && (maxBytes == 0 || total <= maxBytes))
+                break;
+
+            if (std::remove(info.path.c_str()) != 0)
+                continue;
+
+            std::remove((info.path + SLOG_INDEX_EXTENSION).c_str());
+
+            --count;
+            total -= info.size;
+        }
+    }
+}
@@ -0,0 +1,165 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logIndex.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace siof
+{
+    SLOG_INLINE LogIndexWriter::LogIndexWriter() : fd_(-1)
+    {
+        std::memset(&record_, 0, sizeof(record_));
+    }
+
+    SLOG_INLINE LogIndexWriter::~LogIndexWriter()
+    {
+        Close();
+    }
+
+    SLOG_INLINE bool LogIndexWriter::Open(const std::string & path)
+    {
+        Close();
+
+#ifdef _WIN32
+        fd_ = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+        if (fd_ < 0)
+            return false;
+
+        struct stat st;
+        std::uint64_t size = fstat(fd_, &st) == 0 ? std::uint64_t(st.st_size) : 0;
+
+        if (size < SLOG_INDEX_MAGIC_SIZE)
+        {
+            // new (or never completed) index
+#ifdef _WIN32
+            bool ok = _chsize(fd_, 0) == 0 && _write(fd_, SLOG_INDEX_MAGIC, SLOG_INDEX_MAGIC_SIZE) == SLOG_INDEX_MAGIC_SIZE;
+#else
+            bool ok = ftruncate(fd_, 0) == 0 && write(fd_, SLOG_INDEX_MAGIC, SLOG_INDEX_MAGIC_SIZE) == SLOG_INDEX_MAGIC_SIZE;
+#endif
+            if (!ok)
+            {
+                Close();
+                return false;
+            }
+        }
+        else if ((size - SLOG_INDEX_MAGIC_SIZE) % sizeof(LogIndexRecord))
+        {
+            // record torn by crash would shift all following ones
+            size -= (size - SLOG_INDEX_MAGIC_SIZE) % sizeof(LogIndexRecord);
+#ifdef _WIN32
+            _chsize(fd_, long(size));
+#else
+            while (ftruncate(fd_, off_t(size)) != 0 && errno == EINTR) {}
+#endif
+        }
+
+        record_.size = 0;
+        return true;
+    }
+
+    SLOG_INLINE void LogIndexWriter::Close()
+    {
+        if (fd_ < 0)
+            return;
+
+        WriteRecord();
+
+#ifdef _WIN32
+        _close(fd_);
+#else
+        close(fd_);
+#endif
+        fd_ = -1;
+    }
+
+    SLOG_INLINE void LogIndexWriter::Add(std::uint64_t offset, std::uint64_t size, std::int64_t minTime, std::int64_t maxTime)
+    {
+        if (fd_ < 0 || size == 0)
+            return;
+
+        // lines don't continue unfinished part (e.g. crash handler wrote meanwhile)
+        if (record_.size && offset != record_.offset + record_.size)
+            WriteRecord();
+
+        if (!record_.size)
+        {
+            record_.offset = offset;
+            record_.minTime = minTime;
+            record_.maxTime = maxTime;
+        }
+
+        record_.size += size;
+        record_.minTime = std::min(record_.minTime, minTime);
+        record_.maxTime = std::max(record_.maxTime, maxTime);
+
+        if (record_.size >= SLOG_INDEX_BYTES || record_.maxTime - record_.minTime >= SLOG_INDEX_INTERVAL)
+            WriteRecord();
+    }
+
+    SLOG_INLINE std::int64_t LogIndexWriter::GetTime(const LogTimePoint & time)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    }
+
+    SLOG_INLINE bool LogIndexWriter::Read(const std::string & path, std::vector<LogIndexRecord> & out)
+    {
+        std::ifstream file(path.c_str(), std::ios_base::binary);
+
+        char magic[SLOG_INDEX_MAGIC_SIZE];
+        if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, SLOG_INDEX_MAGIC, sizeof(magic)) != 0)
+            return false;
+
+        // torn last record (crash) is ignored
+        LogIndexRecord record;
+        while (file.read(reinterpret_cast<char *>(&record), sizeof(record)))
+            out.push_back(record);
+
+        return true;
+    }
+
+    SLOG_INLINE void LogIndexWriter::WriteRecord()
+    {
+        if (!record_.size)
+            return;
+
+        char data[sizeof(record_)];
+        std::memcpy(data, &record_, sizeof(record_));
+
+        // failed write only makes readers scan more
+#ifdef _WIN32
+        _write(fd_, data, sizeof(record_));
+#else
+        while (write(fd_, data, sizeof(record_)) < 0 && errno == EINTR) {}
+#endif
+        record_.size = 0;
+    }
+}
@@ -0,0 +1,91 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_INDEX
+#define SIOF_LOGGER_INDEX
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "logConfig.h"
+#include "logTime.h"
+
+namespace siof
+{
+    /// sidecar index of log file is "<log file>.idx"
+    #define SLOG_INDEX_EXTENSION    ".idx"
+    /// index record is written once its part of file has this many bytes or spans this many milliseconds
+    #ifndef SLOG_INDEX_BYTES
+    #define SLOG_INDEX_BYTES        (64 * 1024)
+    #endif
+    #ifndef SLOG_INDEX_INTERVAL
+    #define SLOG_INDEX_INTERVAL     1000
+    #endif
+    /// first bytes of index file (records follow)
+    #define SLOG_INDEX_MAGIC        "SLOGIDX1"
+    #define SLOG_INDEX_MAGIC_SIZE   8
+
+    /// Index record - part of log file (whole lines) and time range of its lines (milliseconds since epoch).
+    /// Records are stored as they are (native byte order).
+    struct LogIndexRecord
+    {
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::int64_t minTime;
+        std::int64_t maxTime;
+    };
+
+    /// Writes sparse time index of log file (LogFileSink::SetIndexed) - lines are added as they are appended
+    /// to file, record is written when its part is complete. Parts of log file without record (unfinished
+    /// part after crash, data written before index existed) have to be scanned by readers.
+    class LogIndexWriter
+    {
+    public:
+        LogIndexWriter();
+        ~LogIndexWriter();
+
+        /// opens index for appending (created when needed), returns false on failure
+        bool Open(const std::string & path);
+        /// writes unfinished part and closes index
+        void Close();
+        bool IsOpen() const { return fd_ >= 0; }
+
+        /// adds size bytes of lines appended at file offset with their time range
+        void Add(std::uint64_t offset, std::uint64_t size, std::int64_t minTime, std::int64_t maxTime);
+
+        /// returns message time as index time
+        static std::int64_t GetTime(const LogTimePoint & time);
+
+        /// reads all records of index, returns false if file can't be read or isn't index
+        static bool Read(const std::string & path, std::vector<LogIndexRecord> & out);
+
+    private:
+        void WriteRecord();
+
+        int fd_;
+        /// unfinished part (empty when size is 0)
+        LogIndexRecord record_;
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logIndex.cpp"
+#endif
+
+#endif // SIOF_LOGGER_INDEX
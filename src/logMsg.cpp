@@ -17,41 +17,107 @@
 
 #include "logMsg.h"
 
-#include <iomanip>
+#include <cstring>
 
 namespace siof
 {
-    LogMsg::LogMsg(const LogMsg& p)
+    SLOG_INLINE LogMsg::LogMsg(const LogMsg& p)
     {
         time_ = p.GetTime();
+        logLevel_ = p.GetLogLevel();
+        category_ = p.GetCategory();
         msg_ = p.GetMsg();
+        fmt_ = p.GetFormat();
+        args_ = p.GetArgs();
     }
 
-    LogMsg::LogMsg(LogLevel logLevel, const std::string & msg)
+    SLOG_INLINE LogMsg::LogMsg(LogLevel logLevel, const std::string & msg)
+    {
+        Set(logLevel, msg);
+    }
+
+    SLOG_INLINE void LogMsg::Set(LogLevel logLevel, const std::string & msg)
     {
         time_ = std::chrono::system_clock::now();
         logLevel_ = logLevel;
-        msg_ = msg;
+        category_ = nullptr;
+        msg_.assign(msg);
+        fmt_ = nullptr;
+        args_.clear();
+        sync_.reset();
+    }
+
+    SLOG_INLINE bool LogMsg::IsRepeatOf(const LogMsg & other) const
+    {
+        if (logLevel_ != other.logLevel_ || category_ != other.category_ || fmt_ != other.fmt_)
+            return false;
+
+        // not yet formatted messages are compared without formatting
+        return fmt_ ? args_ == other.args_ : msg_ == other.msg_;
+    }
+
+    SLOG_INLINE void LogMsg::Reserve(std::size_t msgSize, std::size_t argsSize)
+    {
+        msg_.reserve(msgSize);
+        args_.reserve(argsSize);
+    }
+
+    SLOG_INLINE void LogMsg::SetEncoded(LogLevel logLevel, const char * fmt, const std::string & args)
+    {
+        logLevel_ = logLevel;
+        category_ = nullptr;
+        fmt_ = fmt;
+        args_.assign(args);
+        sync_.reset();
+    }
+
+    SLOG_INLINE void LogMsg::Format()
+    {
+        if (!fmt_)
+            return;
+
+        msg_.clear();
+        LogArgs::Format(fmt_, args_.data(), args_.size(), msg_);
     }
 
-    const std::string & LogMsg::GetMsg() const
+    SLOG_INLINE const char * LogMsg::GetFormat() const
+    {
+        return fmt_;
+    }
+
+    SLOG_INLINE const std::string & LogMsg::GetArgs() const
+    {
+        return args_;
+    }
+
+    SLOG_INLINE const std::string & LogMsg::GetMsg() const
     {
         return msg_;
     }
 
-    std::time_t LogMsg::GetCTime() const
+    SLOG_INLINE std::time_t LogMsg::GetCTime() const
     {
         // commented couse could round to up value
         //return std::chrono::system_clock::to_time_t(time_);
         return std::chrono::duration_cast<std::chrono::seconds>(time_.time_since_epoch()).count();
     }
 
-    const LogTimePoint & LogMsg::GetTime() const
+    SLOG_INLINE const LogTimePoint & LogMsg::GetTime() const
     {
         return time_;
     }
 
-    std::string LogMsg::GetLogLevelStr(LogLevel logLevel)
+    SLOG_INLINE void LogMsg::SetTime(const LogTimePoint & time)
+    {
+        time_ = time;
+    }
+
+    SLOG_INLINE LogLevel LogMsg::GetLogLevel() const
+    {
+        return logLevel_;
+    }
+
+    SLOG_INLINE const char * LogMsg::GetLogLevelStr(LogLevel logLevel)
     {
         switch (logLevel)
         {
@@ -77,25 +143,136 @@ namespace siof
         return "";
     }
 
-    LogMsg & LogMsg::operator = (const LogMsg & p)
+    SLOG_INLINE const char * LogMsg::GetLogLevelName(LogLevel logLevel)
+    {
+        switch (logLevel)
+        {
+            case SLOG_LEVEL_DEBUG:
+                return "DEBUG";
+            case SLOG_LEVEL_DEBUG2:
+                return "DEBUG2";
+            case SLOG_LEVEL_WARNING:
+                return "WARNING";
+            case SLOG_LEVEL_ERROR:
+                return "ERROR";
+            case SLOG_LEVEL_FATAL:
+                return "FATAL";
+            case SLOG_LEVEL_EXCEPTION:
+                return "EXCEPTION";
+            case SLOG_LEVEL_INFO:
+                return "INFO";
+            case SLOG_LEVEL_NONE:
+            default:
+                break;
+        }
+
+        return "NONE";
+    }
+
+    SLOG_INLINE LogMsg & LogMsg::operator = (const LogMsg & p)
     {
         time_ = p.GetTime();
+        logLevel_ = p.GetLogLevel();
+        category_ = p.GetCategory();
         msg_ = p.GetMsg();
+        fmt_ = p.GetFormat();
+        args_ = p.GetArgs();
 
         return *this;
     }
 
-    std::ostream & operator<< (std::ostream & out, const LogMsg & msg)
+    SLOG_INLINE std::size_t LogMsg::Render(std::string & out, LogTimeCache & timeCache, LogFormat format) const
     {
-        // seconds
-        std::time_t tmpTime = msg.GetCTime();
-        // miliseconds
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(msg.time_ - std::chrono::system_clock::from_time_t(tmpTime));
+        char timeStr[SLOG_TIME_SIZE + 6];
+        timeCache.Render(time_, timeStr);
 
-        out << std::put_time(std::localtime(&tmpTime), "%Y-%m-%d %H:%M:%S.");
-        out << std::setw(3) << ms.count();
-        out << std::setw(0) << " " << LogMsg::GetLogLevelStr(msg.logLevel_) << msg.msg_ << "\n";//std::endl;
+        std::size_t begin = out.size();
 
-        return out;
-}
+        if (format == SLOG_FORMAT_TEXT)
+        {
+            out.append(timeStr, SLOG_TIME_SIZE);
+            out += ' ';
+            out += GetLogLevelStr(logLevel_);
+
+            begin = out.size();
+
+            if (category_)
+            {
+                out += '[';
+                out += category_;
+                out += "] ";
+            }
+
+            out += msg_;
+        }
+        else
+        {
+            // ISO 8601 with UTC offset: YYYY-MM-DDTHH:MM:SS.mmm+hh:mm
+            long offset = timeCache.GetUtcOffset();
+            long minutes = (offset < 0 ? -offset : offset) / 60;
+
+            timeStr[10] = 'T';
+            timeStr[SLOG_TIME_SIZE] = offset < 0 ? '-' : '+';
+            timeStr[SLOG_TIME_SIZE + 1] = char('0' + minutes / 600 % 10);
+            timeStr[SLOG_TIME_SIZE + 2] = char('0' + minutes / 60 % 10);
+            timeStr[SLOG_TIME_SIZE + 3] = ':';
+            timeStr[SLOG_TIME_SIZE + 4] = char('0' + minutes % 60 / 10);
+            timeStr[SLOG_TIME_SIZE + 5] = char('0' + minutes % 10);
+
+            if (format == SLOG_FORMAT_JSON)
+            {
+                out += "{\"ts\":\"";
+                out.append(timeStr, sizeof(timeStr));
+                out += "\",\"level\":\"";
+                out += GetLogLevelName(logLevel_);
+
+                if (category_)
+                {
+                    out += "\",\"category\":\"";
+                    LogArgs::AppendEscaped(category_, std::strlen(category_), out);
+                }
+
+                out += "\",\"msg\":\"";
+                LogArgs::AppendEscaped(msg_.data(), msg_.size(), out);
+                out += '"';
+            }
+            else
+            {
+                out += "ts=";
+                out.append(timeStr, sizeof(timeStr));
+                out += " level=";
+                out += GetLogLevelName(logLevel_);
+
+                if (category_)
+                {
+                    out += " category=";
+                    LogArgs::AppendLogfmtValue(category_, std::strlen(category_), out);
+                }
+
+                out += " msg=";
+                LogArgs::AppendLogfmtValue(msg_.data(), msg_.size(), out);
+            }
+        }
+
+        // fields are kept only with not yet formatted messages
+        if (fmt_)
+            LogArgs::FormatFields(args_.data(), args_.size(), format, out);
+
+        if (format == SLOG_FORMAT_JSON)
+            out += '}';
+
+        out += '\n';
+        return begin;
+    }
+
+    SLOG_INLINE std::ostream & operator<< (std::ostream & out, const LogMsg & msg)
+    {
+        static thread_local LogTimeCache timeCache;
+        static thread_local std::string line;
+
+        line.clear();
+        msg.Render(line, timeCache);
+
+        return out.write(line.data(), line.size());
+    }
 }
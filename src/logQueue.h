@@ -0,0 +1,251 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_QUEUE
+#define SIOF_LOGGER_QUEUE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "logMsg.h"
+
+namespace siof
+{
+    #define SLOG_QUEUE_DEFAULT_CAPACITY     8192
+    #define SLOG_CACHE_LINE                 64
+    /// text capacity reserved in every slot when queue is created
+    #ifndef SLOG_MSG_RESERVE
+    #define SLOG_MSG_RESERVE                128
+    #endif
+    /// encoded args capacity reserved in every slot (Logger::Log)
+    #ifndef SLOG_ARGS_RESERVE
+    #define SLOG_ARGS_RESERVE               64
+    #endif
+
+    /// Bounded lock-free multi producer / single consumer ring of preallocated
+    /// LogMsg slots. Every slot carries a sequence number which tells if it is
+    /// free for producer (seq == pos) or ready for consumer (seq == pos + 1).
+    /// Slots are reused so msg strings keep their capacity. Capacity is reserved
+    /// up front (SLOG_MSG_RESERVE, SLOG_ARGS_RESERVE), so shorter messages never allocate
+    /// and longer ones only until their slots have grown.
+    /// Queue created as single producer skips CAS on head (only owner thread may push).
+    /// Ready messages are claimed by CAS on tail, so producers can discard oldest message
+    /// (DiscardOldest) while consumer works on messages it already took.
+    class LogQueue
+    {
+    public:
+        /// capacity is rounded up to power of 2
+        explicit LogQueue(std::size_t capacity = SLOG_QUEUE_DEFAULT_CAPACITY, bool singleProducer = false)
+            : slots_(RoundCapacity(capacity)), mask_(slots_.size() - 1), singleProducer_(singleProducer), head_(0), tail_(0), peekPos_(0)
+        {
+            for (std::size_t i = 0; i < slots_.size(); ++i)
+            {
+                slots_[i].seq.store(i, std::memory_order_relaxed);
+                slots_[i].msg.Reserve(SLOG_MSG_RESERVE, SLOG_ARGS_RESERVE);
+            }
+        }
+
+        /// claims free slot, fills it with given functor (called as fill(LogMsg &))
+        /// and publishes it to consumer. Returns false when queue is full.
+        template <typename Fill>
+        bool TryPush(Fill fill)
+        {
+            Slot * slot = nullptr;
+            std::size_t pos = head_.load(std::memory_order_relaxed);
+
+            if (singleProducer_)
+            {
+                slot = &slots_[pos & mask_];
+                if (slot->seq.load(std::memory_order_acquire) != pos)
+                    return false;
+
+                head_.store(pos + 1, std::memory_order_relaxed);
+            }
+
+            while (!singleProducer_)
+            {
+                slot = &slots_[pos & mask_];
+                std::size_t seq = slot->seq.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+
+                if (diff == 0)
+                {
+                    if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = head_.load(std::memory_order_relaxed);
+            }
+
+            try
+            {
+                fill(slot->msg);
+            }
+            catch (...)
+            {
+                // slot has to be published anyway, otherwise consumer would stuck on it
+                slot->seq.store(pos + 1, std::memory_order_release);
+                throw;
+            }
+
+            slot->seq.store(pos + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        /// consumer only: takes up to max ready messages (in queue order) and appends them to out.
+        /// Messages stay owned by consumer until Release is called (one Peek before every Release).
+        std::size_t Peek(std::vector<LogMsg *> & out, std::size_t max)
+        {
+            std::size_t pos = tail_.load(std::memory_order_relaxed);
+            std::size_t count;
+
+            while (true)
+            {
+                count = 0;
+                while (count < max && slots_[(pos + count) & mask_].seq.load(std::memory_order_acquire) == pos + count + 1)
+                    ++count;
+
+                // whole run is taken at once - fails only when producer discarded oldest message meanwhile
+                if (count == 0 || tail_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+                    break;
+            }
+
+            for (std::size_t i = 0; i < count; ++i)
+                out.push_back(&slots_[(pos + i) & mask_].msg);
+
+            peekPos_ = pos;
+            return count;
+        }
+
+        /// consumer only: gives back first count peeked slots to producers
+        void Release(std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                std::size_t pos = peekPos_ + i;
+                slots_[pos & mask_].seq.store(pos + mask_ + 1, std::memory_order_release);
+            }
+
+            peekPos_ += count;
+        }
+
+        /// producer: frees oldest ready message (not yet taken by consumer) without writing it,
+        /// discard(LogMsg &) is called before slot is reused. Returns false when there is none.
+        template <typename Discard>
+        bool DiscardOldest(Discard discard)
+        {
+            std::size_t pos = tail_.load(std::memory_order_relaxed);
+
+            while (true)
+            {
+                Slot & slot = slots_[pos & mask_];
+                if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+                    return false;
+
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    discard(slot.msg);
+                    slot.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+        }
+
+        /// returns if there is nothing ready to read
+        bool Empty() const
+        {
+            std::size_t pos = tail_.load(std::memory_order_relaxed);
+            return slots_[pos & mask_].seq.load(std::memory_order_acquire) != pos + 1;
+        }
+
+        /// crash handler only: calls f(const LogMsg &) for every message not yet given back by consumer
+        /// (also ones taken by last Peek). Nothing is synchronized - best effort on dying process.
+        template <typename F>
+        void ForEachPending(F f) const
+        {
+            for (std::size_t pos = peekPos_; pos - peekPos_ <= mask_; ++pos)
+            {
+                const Slot & slot = slots_[pos & mask_];
+                if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+                    break;
+
+                f(slot.msg);
+            }
+        }
+
+        /// returns count of messages pushed so far (any thread)
+        std::uint64_t GetPushed() const
+        {
+            return head_.load(std::memory_order_relaxed);
+        }
+
+        /// returns count of messages waiting for consumer (approximate while producers push)
+        std::size_t GetSize() const
+        {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            std::size_t head = head_.load(std::memory_order_relaxed);
+
+            return head > tail ? head - tail : 0;
+        }
+
+        std::size_t Capacity() const
+        {
+            return mask_ + 1;
+        }
+
+    private:
+        LogQueue(const LogQueue &);
+        LogQueue & operator = (const LogQueue &);
+
+        static std::size_t RoundCapacity(std::size_t capacity)
+        {
+            std::size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+
+            return size;
+        }
+
+        struct Slot
+        {
+            Slot() : seq(0) {}
+
+            std::atomic<std::size_t> seq;
+            LogMsg msg;
+        };
+
+        std::vector<Slot> slots_;
+        std::size_t mask_;
+        bool singleProducer_;
+
+        /// producers position - padded away from consumer data to avoid false sharing
+        char headPad_[SLOG_CACHE_LINE];
+        std::atomic<std::size_t> head_;
+        /// position of oldest message not taken by consumer
+        char tailPad_[SLOG_CACHE_LINE];
+        std::atomic<std::size_t> tail_;
+        /// consumer only: position of first slot taken by last Peek
+        std::size_t peekPos_;
+    };
+}
+
+#endif // SIOF_LOGGER_QUEUE
@@ -0,0 +1,236 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logSink.h"
+
+#include <algorithm>
+
+#include "logThread.h"
+
+namespace siof
+{
+    SLOG_INLINE void LogRenderedBatch::Clear()
+    {
+        text_.clear();
+        lines_.clear();
+    }
+
+    SLOG_INLINE void LogRenderedBatch::Add(LogMsg & msg, LogTimeCache & timeCache, LogFormat format)
+    {
+        msg.Format();
+
+        LogRenderedLine line;
+        line.begin = text_.size();
+        line.logLevel = msg.GetLogLevel();
+        line.time = msg.GetTime();
+        line.msgBegin = msg.Render(text_, timeCache, format);
+        line.end = text_.size();
+
+        lines_.push_back(line);
+    }
+
+    SLOG_INLINE void LogRenderedBatch::Add(const LogRenderedBatch & batch, std::size_t index)
+    {
+        const LogRenderedLine & src = batch.lines_[index];
+
+        LogRenderedLine line;
+        line.begin = text_.size();
+        line.msgBegin = line.begin + (src.msgBegin - src.begin);
+        line.end = line.begin + (src.end - src.begin);
+        line.logLevel = src.logLevel;
+        line.time = src.time;
+
+        text_.append(batch.text_, src.begin, src.end - src.begin);
+        lines_.push_back(line);
+    }
+
+    SLOG_INLINE void LogSink::Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last)
+    {
+        const std::string & text = batch.GetText();
+
+        // consecutive accepted lines are written at once (whole batch when there is no filter)
+        std::size_t runBegin = 0;
+        std::size_t runEnd = 0;
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const LogRenderedLine & line = batch.GetLine(i);
+
+            if (!Accepts(line.logLevel))
+                continue;
+
+            if (runEnd != line.begin || runBegin == runEnd)
+            {
+                if (runBegin != runEnd)
+                    WriteData(text.data() + runBegin, runEnd - runBegin);
+
+                runBegin = line.begin;
+            }
+
+            runEnd = line.end;
+        }
+
+        if (runBegin != runEnd)
+            WriteData(text.data() + runBegin, runEnd - runBegin);
+    }
+
+    SLOG_INLINE LogAsyncSink::LogAsyncSink(const std::shared_ptr<LogSink> & sink, std::size_t maxPending) : sink_(sink),
+        maxPending_(maxPending), force_(false), closing_(false), dropped_(0)
+    {
+    }
+
+    SLOG_INLINE LogAsyncSink::~LogAsyncSink()
+    {
+        Close();
+    }
+
+    SLOG_INLINE void LogAsyncSink::Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const LogRenderedLine & line = batch.GetLine(i);
+
+            if (!Accepts(line.logLevel) || !sink_->Accepts(line.logLevel))
+                continue;
+
+            if (pending_.GetText().size() + (line.end - line.begin) > maxPending_)
+            {
+                ++dropped_;
+                continue;
+            }
+
+            pending_.Add(batch, i);
+        }
+
+        if (!thread_ && pending_.GetCount())
+        {
+            closing_ = false;
+            thread_ = std::shared_ptr<std::thread>(new std::thread(&LogAsyncSink::Run, this));
+        }
+    }
+
+    SLOG_INLINE void LogAsyncSink::Commit(bool force)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        force_ = force_ || force;
+
+        if (pending_.GetCount())
+            cond_.notify_one();
+    }
+
+    SLOG_INLINE void LogAsyncSink::Close()
+    {
+        std::shared_ptr<std::thread> tmpThread;
+
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            closing_ = true;
+            tmpThread.swap(thread_);
+            cond_.notify_one();
+        }
+
+        if (tmpThread && tmpThread->joinable())
+            tmpThread->join();
+
+        sink_->Close();
+    }
+
+    SLOG_INLINE void LogAsyncSink::Run()
+    {
+        SetCurrentThreadName(SLOG_SINK_THREAD_NAME);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (true)
+        {
+            cond_.wait(lock, [this] () -> bool { return pending_.GetCount() || closing_; });
+
+            if (pending_.GetCount())
+            {
+                std::swap(pending_, writing_);
+                bool force = force_;
+                force_ = false;
+
+                lock.unlock();
+
+                try
+                {
+                    sink_->Write(writing_, 0, writing_.GetCount());
+                    sink_->Commit(force);
+                }
+                catch (std::exception &)
+                {
+                    // sink failure must not stop logging - lines are lost
+                }
+
+                writing_.Clear();
+                lock.lock();
+
+                continue;
+            }
+
+            if (closing_)
+                return;
+        }
+    }
+
+    SLOG_INLINE void LogDispatcher::Add(const std::shared_ptr<LogSink> & sink)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        sinks_.push_back(sink);
+        count_ = sinks_.size();
+    }
+
+    SLOG_INLINE void LogDispatcher::Remove(const std::shared_ptr<LogSink> & sink)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        sinks_.erase(std::remove(sinks_.begin(), sinks_.end(), sink), sinks_.end());
+        count_ = sinks_.size();
+    }
+
+    SLOG_INLINE void LogDispatcher::Dispatch(const LogRenderedBatch & batch, bool force)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        for (auto & sink : sinks_)
+        {
+            try
+            {
+                sink->Write(batch, 0, batch.GetCount());
+                sink->Commit(force);
+            }
+            catch (std::exception &)
+            {
+                // one failing sink must not stop others
+            }
+        }
+    }
+
+    SLOG_INLINE void LogDispatcher::Close()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        for (auto & sink : sinks_)
+            sink->Close();
+    }
+}
@@ -0,0 +1,184 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logSinks.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "logFileSink.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace siof
+{
+    SLOG_INLINE void LogStreamSink::WriteData(const char * data, std::size_t size)
+    {
+        detail::WriteAll(fd_, data, size);
+    }
+
+    SLOG_INLINE LogSyslogSink::LogSyslogSink(const std::string & ident, int facility, const std::string & path) : ident_(ident),
+        facility_(facility), path_(path), fd_(-1)
+    {
+    }
+
+    SLOG_INLINE LogSyslogSink::~LogSyslogSink()
+    {
+        Close();
+    }
+
+    SLOG_INLINE int LogSyslogSink::GetSeverity(LogLevel logLevel)
+    {
+        switch (logLevel)
+        {
+            case SLOG_LEVEL_DEBUG:
+            case SLOG_LEVEL_DEBUG2:
+                return 7;   // debug
+            case SLOG_LEVEL_WARNING:
+                return 4;   // warning
+            case SLOG_LEVEL_ERROR:
+            case SLOG_LEVEL_EXCEPTION:
+                return 3;   // err
+            case SLOG_LEVEL_FATAL:
+                return 2;   // crit
+            default:
+                return 6;   // info
+        }
+    }
+
+#ifdef _WIN32
+    SLOG_INLINE void LogSyslogSink::Write(const LogRenderedBatch &, std::size_t, std::size_t) {}
+    SLOG_INLINE void LogSyslogSink::Close() {}
+    SLOG_INLINE bool LogSyslogSink::Connect() { return false; }
+#else
+    SLOG_INLINE bool LogSyslogSink::Connect()
+    {
+        if (fd_ >= 0)
+            return true;
+
+        fd_ = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (fd_ < 0)
+            return false;
+
+        fcntl(fd_, F_SETFD, FD_CLOEXEC);
+
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+
+        if (connect(fd_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    SLOG_INLINE void LogSyslogSink::Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last)
+    {
+        const std::string & text = batch.GetText();
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const LogRenderedLine & line = batch.GetLine(i);
+
+            if (!Accepts(line.logLevel) || !Connect())
+                continue;
+
+            datagram_ = "<" + std::to_string(facility_ * 8 + GetSeverity(line.logLevel)) + ">";
+            datagram_ += ident_;
+            datagram_ += ": ";
+            datagram_.append(text, line.msgBegin, line.end - 1 - line.msgBegin);
+
+            // never wait for syslog - line is lost when its buffer is full
+            if (send(fd_, datagram_.data(), datagram_.size(), MSG_DONTWAIT) < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                Close();    // syslog restarted - reconnect with next line
+        }
+    }
+
+    SLOG_INLINE void LogSyslogSink::Close()
+    {
+        if (fd_ >= 0)
+            close(fd_);
+
+        fd_ = -1;
+    }
+#endif
+
+    SLOG_INLINE LogMemorySink::LogMemorySink(std::size_t maxLines) : lines_(maxLines ? maxLines : 1), next_(0), count_(0)
+    {
+    }
+
+    SLOG_INLINE void LogMemorySink::Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last)
+    {
+        const std::string & text = batch.GetText();
+
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const LogRenderedLine & line = batch.GetLine(i);
+
+            if (!Accepts(line.logLevel))
+                continue;
+
+            // assign keeps string capacity - no allocations once ring is filled
+            lines_[next_].assign(text, line.begin, line.end - 1 - line.begin);
+            next_ = (next_ + 1) % lines_.size();
+            count_ = std::min(count_ + 1, lines_.size());
+        }
+    }
+
+    SLOG_INLINE void LogMemorySink::GetLines(std::vector<std::string> & out) const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        std::size_t start = (next_ + lines_.size() - count_) % lines_.size();
+
+        for (std::size_t i = 0; i < count_; ++i)
+            out.push_back(lines_[(start + i) % lines_.size()]);
+    }
+
+    SLOG_INLINE void LogMemorySink::Clear()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        next_ = 0;
+        count_ = 0;
+    }
+
+    SLOG_INLINE void LogCallbackSink::Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last)
+    {
+        const std::string & text = batch.GetText();
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const LogRenderedLine & line = batch.GetLine(i);
+
+            if (Accepts(line.logLevel))
+                callback_(line.logLevel, text.data() + line.begin, line.end - 1 - line.begin);
+        }
+    }
+}
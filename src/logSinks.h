@@ -0,0 +1,121 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_SINKS
+#define SIOF_LOGGER_SINKS
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "logConfig.h"
+#include "logSink.h"
+
+namespace siof
+{
+    /// default path of local syslog socket
+    #define SLOG_SYSLOG_PATH        "/dev/log"
+    /// syslog facility "user"
+    #define SLOG_SYSLOG_FACILITY    1
+
+    enum LogStream
+    {
+        SLOG_STREAM_STDOUT      = 1,
+        SLOG_STREAM_STDERR      = 2
+    };
+
+    /// Writes lines to stdout/stderr descriptor with write(2) - add it with own thread
+    /// when output can block (pipe, terminal)
+    class LogStreamSink : public LogSink
+    {
+    public:
+        explicit LogStreamSink(LogStream stream = SLOG_STREAM_STDERR) : fd_(stream) {}
+
+    protected:
+        void WriteData(const char * data, std::size_t size) override;
+
+    private:
+        int fd_;
+    };
+
+    /// Sends every line as datagram to local syslog socket ("<PRI>ident: message").
+    /// Socket is (re)connected lazily, lines are lost while syslog is not available.
+    /// Does nothing on Windows.
+    class LogSyslogSink : public LogSink
+    {
+    public:
+        explicit LogSyslogSink(const std::string & ident, int facility = SLOG_SYSLOG_FACILITY, const std::string & path = SLOG_SYSLOG_PATH);
+        ~LogSyslogSink();
+
+        void Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last) override;
+        void Close() override;
+
+        /// returns syslog severity for log level
+        static int GetSeverity(LogLevel logLevel);
+
+    private:
+        bool Connect();
+
+        std::string ident_;
+        int facility_;
+        std::string path_;
+        int fd_;
+        std::string datagram_;
+    };
+
+    /// Keeps last maxLines lines (without '\n') in memory, e.g. for diagnostics page or tests
+    class LogMemorySink : public LogSink
+    {
+    public:
+        explicit LogMemorySink(std::size_t maxLines);
+
+        void Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last) override;
+
+        /// copies kept lines (oldest first) to out
+        void GetLines(std::vector<std::string> & out) const;
+        void Clear();
+
+    private:
+        std::vector<std::string> lines_;
+        /// index of oldest line when ring is full
+        std::size_t next_;
+        std::size_t count_;
+        mutable std::mutex mutex_;
+    };
+
+    /// Calls function for every line (line without '\n')
+    class LogCallbackSink : public LogSink
+    {
+    public:
+        typedef std::function<void (LogLevel logLevel, const char * line, std::size_t size)> Callback;
+
+        explicit LogCallbackSink(const Callback & callback) : callback_(callback) {}
+
+        void Write(const LogRenderedBatch & batch, std::size_t first, std::size_t last) override;
+
+    private:
+        Callback callback_;
+    };
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logSinks.cpp"
+#endif
+
+#endif // SIOF_LOGGER_SINKS
@@ -0,0 +1,109 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logThread.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace siof
+{
+    namespace detail
+    {
+        /// set_mempolicy mode MPOL_LOCAL: allocate on node of CPU which allocates (linux/mempolicy.h, Linux 3.8+,
+        /// numaif.h needs libnuma headers)
+        const int mpolLocal = 4;
+
+        /// remembers first failure only - later ones are usually caused by it
+        inline void SetPlacementError(std::string & error, const char * what, int errorNumber)
+        {
+            if (error.empty())
+                error = std::string(what) + ": " + strerror(errorNumber);
+        }
+    }
+
+#ifdef __linux__
+    SLOG_INLINE bool LogThreadPlacement::ApplyToCurrentThread(std::string & error) const
+    {
+        error.clear();
+
+        if (!name.empty())
+            SetCurrentThreadName(name);
+
+        if (!cpus.empty())
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+
+            for (int cpu : cpus)
+            {
+                if (cpu >= 0 && cpu < CPU_SETSIZE)
+                    CPU_SET(cpu, &set);
+            }
+
+            if (sched_setaffinity(0, sizeof(set), &set) != 0)
+                detail::SetPlacementError(error, "sched_setaffinity", errno);
+        }
+
+        if (policy >= 0)
+        {
+            sched_param param;
+            memset(&param, 0, sizeof(param));
+            param.sched_priority = priority;
+
+            int result = pthread_setschedparam(pthread_self(), policy, &param);
+            if (result != 0)
+                detail::SetPlacementError(error, "pthread_setschedparam", result);
+        }
+
+        // nice value is per thread on Linux (thread id instead of process id)
+        if (setNice && setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), niceValue) != 0)
+            detail::SetPlacementError(error, "setpriority", errno);
+
+        // after pinning, so pages are taken from node of pinned CPUs
+        if (localMemory && syscall(SYS_set_mempolicy, detail::mpolLocal, nullptr, 0) != 0)
+            detail::SetPlacementError(error, "set_mempolicy", errno);
+
+        return error.empty();
+    }
+
+    SLOG_INLINE void SetCurrentThreadName(const std::string & name)
+    {
+        pthread_setname_np(pthread_self(), name.substr(0, SLOG_THREAD_NAME_SIZE).c_str());
+    }
+#else
+    SLOG_INLINE bool LogThreadPlacement::ApplyToCurrentThread(std::string & error) const
+    {
+        error.clear();
+
+        if (!cpus.empty() || policy >= 0 || setNice || localMemory)
+            detail::SetPlacementError(error, "thread placement", ENOSYS);
+
+        return error.empty();
+    }
+
+    SLOG_INLINE void SetCurrentThreadName(const std::string &) {}
+#endif
+}
@@ -0,0 +1,66 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIOF_LOGGER_THREAD
+#define SIOF_LOGGER_THREAD
+
+#include <string>
+#include <vector>
+
+#include "logConfig.h"
+
+namespace siof
+{
+    /// names of logger threads (shown by top -H, perf, gdb), logging thread name can be changed
+    #define SLOG_WRITER_THREAD_NAME         "slog_writer"
+    #define SLOG_SINK_THREAD_NAME           "slog_sink"
+    #define SLOG_HOUSEKEEPER_THREAD_NAME    "slog_housekeep"
+    /// max thread name length on Linux (without terminating zero)
+    #define SLOG_THREAD_NAME_SIZE           15
+
+    /// Where and how thread runs: name, CPU set, scheduling policy and nice value,
+    /// memory allocated on NUMA node of its CPUs. Applied by thread to itself, Linux only.
+    struct LogThreadPlacement
+    {
+        LogThreadPlacement() : policy(-1), priority(0), setNice(false), niceValue(0), localMemory(false) {}
+
+        /// empty - name not changed (longer names are cut to SLOG_THREAD_NAME_SIZE)
+        std::string name;
+        /// CPUs thread may run on (empty - not pinned)
+        std::vector<int> cpus;
+        /// SCHED_OTHER, SCHED_FIFO, SCHED_RR, SCHED_BATCH, SCHED_IDLE (-1 - not changed)
+        int policy;
+        /// static priority of SCHED_FIFO / SCHED_RR
+        int priority;
+        bool setNice;
+        int niceValue;
+        /// new allocations of thread come from NUMA node it runs on (whatever process memory policy is)
+        bool localMemory;
+
+        /// applies placement to calling thread, returns false (and description of first failure) if anything failed
+        bool ApplyToCurrentThread(std::string & error) const;
+    };
+
+    /// names calling thread (does nothing when not supported)
+    void SetCurrentThreadName(const std::string & name);
+}
+
+#ifdef SLOG_HEADER_ONLY
+#include "logThread.cpp"
+#endif
+
+#endif // SIOF_LOGGER_THREAD
@@ -0,0 +1,143 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logTime.h"
+
+#include <cstring>
+
+namespace siof
+{
+    namespace detail
+    {
+        /// writes value as count zero padded digits
+        inline void WriteDigits(char * out, int value, int count)
+        {
+            for (int i = count - 1; i >= 0; --i)
+            {
+                out[i] = char('0' + value % 10);
+                value /= 10;
+            }
+        }
+
+        /// days since 1970-01-01 of civil date (month 1-12)
+        SLOG_INLINE long DaysFromCivil(long year, unsigned int month, unsigned int day)
+        {
+            year -= month <= 2;
+            long era = (year >= 0 ? year : year - 399) / 400;
+            unsigned int yoe = unsigned(year - era * 400);
+            unsigned int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+            return era * 146097 + long(doe) - 719468;
+        }
+
+        /// civil date of days since 1970-01-01
+        SLOG_INLINE void CivilFromDays(long days, long & year, unsigned int & month, unsigned int & day)
+        {
+            days += 719468;
+            long era = (days >= 0 ? days : days - 146096) / 146097;
+            unsigned int doe = unsigned(days - era * 146097);
+            unsigned int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            unsigned int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            unsigned int mp = (5 * doy + 2) / 153;
+
+            day = doy - (153 * mp + 2) / 5 + 1;
+            month = mp < 10 ? mp + 3 : mp - 9;
+            year = long(yoe) + era * 400 + (month <= 2);
+        }
+    }
+
+    SLOG_INLINE bool LocalTime(std::time_t time, std::tm & out)
+    {
+#ifdef _WIN32
+        return localtime_s(&out, &time) == 0;
+#else
+        return localtime_r(&time, &out) != nullptr;
+#endif
+    }
+
+    SLOG_INLINE void LogTimeCache::Render(const LogTimePoint & time, char * out)
+    {
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+        std::time_t second = std::time_t(ms / 1000);
+
+        Update(second);
+
+        std::memcpy(out, prefix_, SLOG_TIME_SECONDS_SIZE);
+        detail::WriteDigits(out + SLOG_TIME_SECONDS_SIZE, int(ms % 1000), 3);
+    }
+
+    SLOG_INLINE void LogTimeCache::Refresh(std::time_t second)
+    {
+        std::tm tmpTm;
+        std::memset(&tmpTm, 0, sizeof(tmpTm));
+        LocalTime(second, tmpTm);
+
+        // YYYY-MM-DD HH:MM:SS.
+        detail::WriteDigits(prefix_, tmpTm.tm_year + 1900, 4);
+        prefix_[4] = '-';
+        detail::WriteDigits(prefix_ + 5, tmpTm.tm_mon + 1, 2);
+        prefix_[7] = '-';
+        detail::WriteDigits(prefix_ + 8, tmpTm.tm_mday, 2);
+        prefix_[10] = ' ';
+        detail::WriteDigits(prefix_ + 11, tmpTm.tm_hour, 2);
+        prefix_[13] = ':';
+        detail::WriteDigits(prefix_ + 14, tmpTm.tm_min, 2);
+        prefix_[16] = ':';
+        detail::WriteDigits(prefix_ + 17, tmpTm.tm_sec, 2);
+        prefix_[19] = '.';
+
+        second_ = second;
+        day_ = (tmpTm.tm_year + 1900) * 1000 + tmpTm.tm_yday;
+
+        long localSeconds = detail::DaysFromCivil(tmpTm.tm_year + 1900, tmpTm.tm_mon + 1, tmpTm.tm_mday) * 86400L +
+                            tmpTm.tm_hour * 3600L + tmpTm.tm_min * 60L + tmpTm.tm_sec;
+        utcOffset_ = long(localSeconds - second);
+    }
+
+    SLOG_INLINE void LogTimeCache::RenderSafe(const LogTimePoint & time, long utcOffset, char * out)
+    {
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+        long long local = ms / 1000 + utcOffset;
+
+        long days = long(local / 86400);
+        long daySeconds = long(local % 86400);
+        if (daySeconds < 0)
+        {
+            daySeconds += 86400;
+            --days;
+        }
+
+        long year;
+        unsigned int month, day;
+        detail::CivilFromDays(days, year, month, day);
+
+        detail::WriteDigits(out, int(year), 4);
+        out[4] = '-';
+        detail::WriteDigits(out + 5, int(month), 2);
+        out[7] = '-';
+        detail::WriteDigits(out + 8, int(day), 2);
+        out[10] = ' ';
+        detail::WriteDigits(out + 11, int(daySeconds / 3600), 2);
+        out[13] = ':';
+        detail::WriteDigits(out + 14, int(daySeconds / 60 % 60), 2);
+        out[16] = ':';
+        detail::WriteDigits(out + 17, int(daySeconds % 60), 2);
+        out[19] = '.';
+        detail::WriteDigits(out + SLOG_TIME_SECONDS_SIZE, int(ms % 1000), 3);
+    }
+}
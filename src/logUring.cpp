@@ -0,0 +1,226 @@
+/*
+*    SLogger - Simple/Safe(thread safe)/siof(?) Logger
+*    Copyright (C) 2014 siof
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logUring.h"
+
+#ifdef SLOG_HAS_IO_URING
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace siof
+{
+    SLOG_INLINE LogUring::LogUring() : fd_(-1), sqRing_(nullptr), sqRingSize_(0), cqRing_(nullptr), cqRingSize_(0), sqes_(nullptr),
+        sqesSize_(0), sqHead_(nullptr), sqTail_(nullptr), sqMask_(0), sqEntries_(0), sqArray_(nullptr), cqHead_(nullptr),
+        cqTail_(nullptr), cqMask_(0), cqes_(nullptr), toSubmit_(0)
+    {
+    }
+
+    SLOG_INLINE LogUring::~LogUring()
+    {
+        Close();
+    }
+
+#ifndef SLOG_HAS_IO_URING
+    SLOG_INLINE bool LogUring::Init(unsigned int) { return false; }
+    SLOG_INLINE void LogUring::Close() {}
+    SLOG_INLINE bool LogUring::Write(int, const void *, std::size_t, std::uint64_t, std::uint64_t) { return false; }
+    SLOG_INLINE bool LogUring::Submit(unsigned int) { return false; }
+    SLOG_INLINE bool LogUring::Reap(std::uint64_t &, int &) { return false; }
+#else
+    namespace detail
+    {
+        /// ring indexes are shared with kernel - head/tail updates need acquire/release ordering
+        inline unsigned int LoadAcquire(const unsigned int * value)
+        {
+            return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+        }
+
+        inline void StoreRelease(unsigned int * value, unsigned int newValue)
+        {
+            __atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+        }
+
+        template <class T>
+        inline T * RingField(void * ring, unsigned int offset)
+        {
+            return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+        }
+    }
+
+    SLOG_INLINE bool LogUring::Init(unsigned int entries)
+    {
+        Close();
+
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        int fd = int(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+            return false;
+
+        fd_ = fd;
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        // 5.4+ kernels map both rings with single mmap
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+        void * ring = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (ring == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+
+        sqRing_ = ring;
+
+        if (singleMap)
+            cqRing_ = sqRing_;
+        else
+        {
+            ring = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            if (ring == MAP_FAILED)
+            {
+                Close();
+                return false;
+            }
+
+            cqRing_ = ring;
+        }
+
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        ring = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (ring == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+
+        sqes_ = ring;
+
+        sqHead_ = detail::RingField<unsigned int>(sqRing_, params.sq_off.head);
+        sqTail_ = detail::RingField<unsigned int>(sqRing_, params.sq_off.tail);
+        sqMask_ = *detail::RingField<unsigned int>(sqRing_, params.sq_off.ring_mask);
+        sqEntries_ = *detail::RingField<unsigned int>(sqRing_, params.sq_off.ring_entries);
+        sqArray_ = detail::RingField<unsigned int>(sqRing_, params.sq_off.array);
+
+        cqHead_ = detail::RingField<unsigned int>(cqRing_, params.cq_off.head);
+        cqTail_ = detail::RingField<unsigned int>(cqRing_, params.cq_off.tail);
+        cqMask_ = *detail::RingField<unsigned int>(cqRing_, params.cq_off.ring_mask);
+        cqes_ = detail::RingField<void>(cqRing_, params.cq_off.cqes);
+
+        toSubmit_ = 0;
+        return true;
+    }
+
+    SLOG_INLINE void LogUring::Close()
+    {
+        if (sqes_)
+            munmap(sqes_, sqesSize_);
+
+        if (cqRing_ && cqRing_ != sqRing_)
+            munmap(cqRing_, cqRingSize_);
+
+        if (sqRing_)
+            munmap(sqRing_, sqRingSize_);
+
+        // closing ring waits for requests still in flight
+        if (fd_ >= 0)
+            close(fd_);
+
+        fd_ = -1;
+        sqRing_ = cqRing_ = sqes_ = cqes_ = nullptr;
+        sqHead_ = sqTail_ = sqArray_ = cqHead_ = cqTail_ = nullptr;
+        toSubmit_ = 0;
+    }
+
+    SLOG_INLINE bool LogUring::Write(int fd, const void * data, std::size_t size, std::uint64_t offset, std::uint64_t userData)
+    {
+        if (fd_ < 0)
+            return false;
+
+        // only this thread moves tail, kernel moves head
+        unsigned int tail = *sqTail_;
+        if (tail - detail::LoadAcquire(sqHead_) >= sqEntries_)
+            return false;
+
+        unsigned int index = tail & sqMask_;
+        io_uring_sqe * sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+
+        memset(sqe, 0, sizeof(io_uring_sqe));
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = fd;
+        sqe->addr = std::uint64_t(reinterpret_cast<std::uintptr_t>(data));
+        sqe->len = unsigned(size);
+        sqe->off = offset;
+        sqe->user_data = userData;
+
+        sqArray_[index] = index;
+        detail::StoreRelease(sqTail_, tail + 1);
+        ++toSubmit_;
+
+        return true;
+    }
+
+    SLOG_INLINE bool LogUring::Submit(unsigned int minComplete)
+    {
+        if (fd_ < 0)
+            return false;
+
+        while (true)
+        {
+            int result = int(syscall(__NR_io_uring_enter, fd_, toSubmit_, minComplete, minComplete ? IORING_ENTER_GETEVENTS : 0u,
+                nullptr, 0));
+
+            if (result >= 0)
+            {
+                toSubmit_ -= std::min(toSubmit_, unsigned(result));
+                return true;
+            }
+
+            if (errno != EINTR)
+                return false;
+        }
+    }
+
+    SLOG_INLINE bool LogUring::Reap(std::uint64_t & userData, int & result)
+    {
+        if (fd_ < 0)
+            return false;
+
+        unsigned int head = *cqHead_;
+        if (head == detail::LoadAcquire(cqTail_))
+            return false;
+
+        const io_uring_cqe * cqe = static_cast<const io_uring_cqe *>(cqes_) + (head & cqMask_);
+        userData = cqe->user_data;
+        result = cqe->res;
+
+        detail::StoreRelease(cqHead_, head + 1);
+        return true;
+    }
+#endif
+}
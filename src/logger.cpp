@@ -17,21 +17,120 @@
 
 #include "logger.h"
 
+#include "logCrash.h"
+
 #include <algorithm>
+#include <cerrno>
 #include <cstdarg>
-#include <iomanip>
+#include <cstring>
+#include <ctime>
 #include <iostream>
 
+#include <sys/stat.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace siof
 {
+    namespace detail
+    {
+        /// queues created by current thread (logger id -> queue)
+        struct ThreadQueues
+        {
+            ~ThreadQueues()
+            {
+                for (auto & p : queues)
+                    p.second->abandoned = true;
+            }
+
+            std::vector<std::pair<std::uint64_t, std::shared_ptr<LogThreadQueue> > > queues;
+        };
+
+        /// spin-wait hint - lets sibling hyper-thread run and saves power
+        SLOG_INLINE void CpuRelax()
+        {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+            _mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            __asm__ __volatile__("yield");
+#endif
+        }
+
+        /// async-signal-safe sleep (crash handler)
+        SLOG_INLINE void SleepSafe(long ms)
+        {
+#ifdef _WIN32
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#else
+            struct timespec delay;
+            delay.tv_sec = ms / 1000;
+            delay.tv_nsec = ms % 1000 * 1000000L;
+
+            // interrupted sleep continues with remaining time
+            while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {}
+#endif
+        }
+    }
+
+    /// only creates logger
+    SLOG_INLINE Logger::Logger() : closing_(false), writerRunning_(false), minLogLevel_(SLOG_LEVEL_NONE), categories_(SLOG_LEVEL_NONE),
+        overflowPolicy_(SLOG_OVERFLOW_BLOCK), overflowLevel_(SLOG_LEVEL_NONE), dropped_(0), droppedReported_(0),
+        rateInterval_(0), rateBurst_(0), rateLimits_(SLOG_RATE_LIMIT_SLOTS), rateLimited_(0), lastMsgValid_(false), repeats_(0),
+        recorderCapacity_(0), recordLevel_(SLOG_LEVEL_NONE),
+        waitStrategy_(SLOG_WAIT_PARK), batchInterval_(SLOG_WRITER_BATCH_INTERVAL), writerSleeping_(false), writerUrgent_(false), queue_(new LogQueue()), queuePeeked_(0),
+        id_(NextId()), threadQueueCapacity_(SLOG_THREAD_QUEUE_DEFAULT_CAPACITY), threadQueuesChanged_(false),
+        separator_(SLOG_SEP_DEFAULT), renderedToFile_(0), outputFormat_(SLOG_FORMAT_TEXT), fileFormat_(SLOG_FORMAT_TEXT), crashHandler_(false), crashing_(false), writerParked_(false), writerIdle_(false), writerId_(std::thread::id()),
+        fileOpenTime_(0), fileOpenDay_(0), fileIndex_(0), rollBytes_(0), rollMinutes_(0), binaryFile_(false)
+    {
+        for (auto & option : options_)
+            option = false;
+
+        for (auto & level : flushLevels_)
+            level = false;
+
+        for (auto & count : droppedLevels_)
+            count = 0;
+
+        for (auto & queue : crashQueues_)
+            queue = nullptr;
+
+        crashQueueCount_ = 0;
+
+        flushLevels_[SLOG_LEVEL_ERROR] = true;
+        flushLevels_[SLOG_LEVEL_FATAL] = true;
+        flushLevels_[SLOG_LEVEL_EXCEPTION] = true;
+
+        for (auto & level : syncLevels_)
+            level = false;
+
+        syncLevels_[SLOG_LEVEL_FATAL] = true;
+        syncLevels_[SLOG_LEVEL_EXCEPTION] = true;
+
+        for (auto & level : recorderTriggers_)
+            level = false;
+
+        recorderTriggers_[SLOG_LEVEL_ERROR] = true;
+        recorderTriggers_[SLOG_LEVEL_FATAL] = true;
+        recorderTriggers_[SLOG_LEVEL_EXCEPTION] = true;
+
+        batch_.reserve(SLOG_BATCH_SIZE);
+
+        writerPlacement_.name = SLOG_WRITER_THREAD_NAME;
+    }
+
     /// dtor
-    Logger::~Logger()
+    SLOG_INLINE Logger::~Logger()
     {
+        EnableCrashHandler(false);
         Close();
     }
 
     /// Here you can set/change filename to save files
-    void Logger::SetFileName(std::string & fileName, std::string extension)
+    SLOG_INLINE void Logger::SetFileName(std::string & fileName, std::string extension)
     {
         std::lock_guard<std::mutex> guard(fileMutex_);
 
@@ -42,20 +141,20 @@ namespace siof
     }
 
     /// Returns actual file name
-    const std::string & Logger::GetFileName() const
+    SLOG_INLINE const std::string & Logger::GetFileName() const
     {
         return fileName_;
     }
 
     /// returns if logging thread is potentially working
-    bool Logger::IsWorking() const
+    SLOG_INLINE bool Logger::IsWorking() const
     {
         // returns if thread is joinable (potentially running)
         return thread_ && thread_->joinable();
     }
 
     /// starts logging thread (if not started)
-    void Logger::Start()
+    SLOG_INLINE void Logger::Start()
     {
         try
         {
@@ -64,6 +163,8 @@ namespace siof
             OpenFileIfNeeded(nullptr);
 
             // and start it again
+            closing_ = false;
+            writerRunning_ = true;
             thread_ = std::shared_ptr<std::thread>(new std::thread(&Logger::LogWriter, this));
         }
         catch (std::exception & e)
@@ -72,7 +173,7 @@ namespace siof
         }
     }
 
-    void Logger::Close()
+    SLOG_INLINE void Logger::Close()
     {
         if (!closeMutex_.try_lock())
             return;
@@ -80,143 +181,444 @@ namespace siof
         if (thread_ && thread_->joinable())
         {
             closing_ = true;
-            canLog_.notify_all();
+            WakeWriter();
 
             thread_->join();
             thread_.reset();
-            file_.flush();
-            file_.close();
+
+            std::lock_guard<std::mutex> guard(fileMutex_);
+            file_.Close();
+            dispatcher_.Close();
+            housekeeper_.Stop();
         }
 
         closeMutex_.unlock();
     }
 
-    void Logger::AddMessage(LogLevel logLevel, const std::string & msg)
+    SLOG_INLINE void Logger::AddMessage(LogLevel logLevel, const char * fmt, ...)
     {
-        if (GetMinimalLogLevel() > logLevel)
+        if (!IsLevelEnabled(logLevel))
             return;
 
-        LogMsg * tmpMsg = nullptr;
+        // reused by every call from this thread
+        static thread_local std::string buffer;
+
+        va_list lst;
+        va_start(lst, fmt);
+
         try
         {
-            std::lock_guard<std::mutex> lock(dataMutex_);
+            va_list tmpLst;
+            va_copy(tmpLst, lst);
+            int size = vsnprintf(nullptr, 0, fmt, tmpLst);
+            va_end(tmpLst);
 
-            tmpMsg = new LogMsg(logLevel, msg);
-            queued_.push_back(std::shared_ptr<LogMsg>(tmpMsg));
+            if (size >= 0)
+            {
+                buffer.resize(size + 1);
+                vsnprintf(&buffer[0], size + 1, fmt, lst);
+                buffer.resize(size);
 
-            canLog_.notify_one();
+                AddMessage(logLevel, buffer);
+            }
         }
         catch (std::exception & e)
         {
             WriteToStdOut(e.what());
-
-            // just in case
-            if (tmpMsg != nullptr)
-                delete tmpMsg;
         }
+
+        va_end(lst);
+    }
+
+    SLOG_INLINE void Logger::SetOption(LoggerOptions option, bool enabled)
+    {
+        options_[option] = enabled;
+    }
+
+    SLOG_INLINE void Logger::SetMinimalLogLevel(LogLevel logLevel)
+    {
+        minLogLevel_ = logLevel;
+        categories_.SetRootLevel(logLevel);
+    }
+
+    SLOG_INLINE LogCategory & Logger::GetCategory(const std::string & name)
+    {
+        return categories_.Get(name);
+    }
+
+    SLOG_INLINE void Logger::SetCategoryLevel(const std::string & name, LogLevel logLevel)
+    {
+        categories_.SetLevel(name, logLevel);
+    }
+
+    SLOG_INLINE void Logger::ResetCategoryLevel(const std::string & name)
+    {
+        categories_.ResetLevel(name);
     }
 
-    void Logger::AddMessage(LogLevel logLevel, const char * fmt, ...)
+    SLOG_INLINE void Logger::SetQueueCapacity(std::size_t capacity)
     {
-        if (GetMinimalLogLevel() > logLevel)
+        if (IsWorking())
             return;
 
-        char * buffer = nullptr;
+        queue_ = std::shared_ptr<LogQueue>(new LogQueue(capacity));
+    }
 
-        va_list lst;
-        va_start(lst, fmt);
+    SLOG_INLINE void Logger::SetThreadQueueCapacity(std::size_t capacity)
+    {
+        threadQueueCapacity_ = capacity;
+    }
+
+    SLOG_INLINE void Logger::SetOverflowPolicy(LogOverflowPolicy policy, LogLevel logLevel)
+    {
+        overflowLevel_ = logLevel;
+        overflowPolicy_ = policy;
+    }
+
+    SLOG_INLINE void Logger::SetRateLimit(double ratePerSecond, unsigned int burst)
+    {
+        rateBurst_ = burst;
+        rateInterval_ = LogRateLimit::GetInterval(ratePerSecond);
+    }
+
+    SLOG_INLINE void Logger::SetWaitStrategy(LogWaitStrategy strategy, unsigned int intervalMs)
+    {
+        batchInterval_ = intervalMs;
+        waitStrategy_ = strategy;
+
+        // thread parked by previous strategy may not be signalled anymore
+        WakeWriter();
+    }
+
+    SLOG_INLINE void Logger::WakeWriter()
+    {
+        std::lock_guard<std::mutex> guard(logMutex_);
+
+        if (writerSleeping_)
+            signals_.Add();
+
+        writerSleeping_ = false;
+        canLog_.notify_one();
+    }
+
+    SLOG_INLINE LogStats Logger::GetStats() const
+    {
+        LogStats stats;
+
+        stats.enqueued = queue_->GetPushed();
+        stats.queueDepth = queue_->GetSize();
 
-        try
         {
-            buffer = new char[strlen(fmt) + 1024];
+            std::lock_guard<std::mutex> guard(threadQueuesMutex_);
 
-            vsprintf(buffer, fmt, lst);
+            stats.enqueued += retiredEnqueued_.Get();
 
-            std::string tmpStr(buffer);
-            AddMessage(logLevel, tmpStr);
+            for (auto & p : threadQueues_)
+            {
+                stats.enqueued += p->queue.GetPushed();
+                stats.queueDepth += p->queue.GetSize();
+            }
         }
-        catch (std::exception & e)
+
+        for (int i = 0; i < SLOG_LEVEL_COUNT; ++i)
         {
-            WriteToStdOut(e.what());
+            stats.written[i] = writtenLevels_[i].Get();
+            stats.dropped[i] = droppedLevels_[i];
         }
 
-        va_end(lst);
+        stats.bytesWritten = file_.GetWrittenBytes();
+        stats.queueDepthPeak = queueDepthPeak_.Get();
+        stats.batches = batches_.Get();
+        batchSizes_.Get(stats.batchSizes);
+        stats.wakeups = wakeups_.Get();
+        stats.idleTimeouts = idleTimeouts_.Get();
+        stats.signals = signals_.Get();
+        stats.rateLimited = rateLimited_;
+        stats.repeats = repeatsCount_.Get();
+        stats.recorded = recordedCount_.Get();
+        stats.recorderDumps = recorderDumps_.Get();
+        file_.GetFlushLatency().Get(stats.flushLatency);
+        stats.rollovers = rollovers_.Get();
+        stats.rolloverTime = rolloverTime_.Get();
 
-        if (buffer != nullptr)
-            delete buffer;
+        return stats;
     }
 
-    void Logger::SetOption(LoggerOptions option, bool enabled)
+    SLOG_INLINE void Logger::SetFlushPolicy(std::size_t bytes, unsigned int intervalMs)
     {
-        options_[option] = enabled;
+        std::lock_guard<std::mutex> guard(fileMutex_);
+
+        file_.SetFlushPolicy(bytes, intervalMs);
     }
 
-    bool Logger::IsOptionSet(LoggerOptions option)
+    SLOG_INLINE void Logger::SetRollingPolicy(std::uint64_t maxBytes, unsigned int intervalMinutes)
     {
-        return options_[option];
+        rollBytes_ = maxBytes;
+        rollMinutes_ = intervalMinutes;
     }
 
-    void Logger::SetMinimalLogLevel(LogLevel logLevel)
+    SLOG_INLINE void Logger::SetRetention(std::size_t maxFiles, std::uint64_t maxBytes)
     {
-        minLogLevel_ = logLevel;
+        housekeeper_.SetRetention(maxFiles, maxBytes);
     }
 
-    LogLevel Logger::GetMinimalLogLevel()
+    SLOG_INLINE void Logger::SetFlushLevel(LogLevel logLevel, bool immediate)
     {
-        return minLogLevel_;
+        flushLevels_[logLevel] = immediate;
     }
 
-    void Logger::OpenFileIfNeeded(const LogMsg * time)
+    SLOG_INLINE void Logger::SetSyncLevel(LogLevel logLevel, bool sync)
     {
-        bool openFile = !file_.is_open();
+        syncLevels_[logLevel] = sync;
+    }
+
+    SLOG_INLINE void Logger::SetFlightRecorder(std::size_t capacity, LogLevel recordLevel)
+    {
+        recordLevel_ = recordLevel;
+        recorderCapacity_ = capacity;
+    }
+
+    SLOG_INLINE void Logger::SetRecorderTrigger(LogLevel logLevel, bool trigger)
+    {
+        recorderTriggers_[logLevel] = trigger;
+    }
+
+    SLOG_INLINE bool Logger::EnableCrashHandler(bool enabled)
+    {
+        if (crashHandler_ == enabled)
+            return true;
+
+        if (enabled && !LogCrashHandler::Register(this))
+            return false;
+
+        if (!enabled)
+            LogCrashHandler::Unregister(this);
+
+        crashHandler_ = enabled;
+        return true;
+    }
+
+    SLOG_INLINE std::shared_ptr<LogSink> Logger::AddSink(const std::shared_ptr<LogSink> & sink, bool ownThread)
+    {
+        std::shared_ptr<LogSink> tmpSink = sink;
+        if (ownThread)
+            tmpSink = std::shared_ptr<LogSink>(new LogAsyncSink(sink));
+
+        dispatcher_.Add(tmpSink);
+        return tmpSink;
+    }
+
+    SLOG_INLINE void Logger::RemoveSink(const std::shared_ptr<LogSink> & sink)
+    {
+        dispatcher_.Remove(sink);
+    }
+
+    SLOG_INLINE void Logger::SetFileLevel(LogLevel logLevel)
+    {
+        file_.SetLevel(logLevel);
+    }
+
+    SLOG_INLINE void Logger::SetOutputFormat(LogFormat format)
+    {
+        outputFormat_ = format;
+    }
+
+    SLOG_INLINE void Logger::SetWriterName(const std::string & name)
+    {
+        std::lock_guard<std::mutex> guard(placementMutex_);
+
+        writerPlacement_.name = name;
+    }
+
+    SLOG_INLINE void Logger::SetWriterAffinity(const std::vector<int> & cpus, bool localMemory)
+    {
+        std::lock_guard<std::mutex> guard(placementMutex_);
+
+        writerPlacement_.cpus = cpus;
+        writerPlacement_.localMemory = localMemory;
+    }
+
+    SLOG_INLINE void Logger::SetWriterScheduling(int policy, int priority, int niceValue)
+    {
+        std::lock_guard<std::mutex> guard(placementMutex_);
+
+        writerPlacement_.policy = policy;
+        writerPlacement_.priority = priority;
+        writerPlacement_.setNice = true;
+        writerPlacement_.niceValue = niceValue;
+    }
+
+    SLOG_INLINE std::uint64_t Logger::NextId()
+    {
+        static std::atomic<std::uint64_t> nextId(1);
+
+        return nextId++;
+    }
+
+    SLOG_INLINE LogQueue & Logger::GetThreadQueue()
+    {
+        static thread_local detail::ThreadQueues threadQueues;
+
+        for (auto & p : threadQueues.queues)
+            if (p.first == id_)
+                return p.second->queue;
+
+        std::shared_ptr<LogThreadQueue> queue(new LogThreadQueue(threadQueueCapacity_));
+        threadQueues.queues.push_back(std::make_pair(id_, queue));
+
+        std::lock_guard<std::mutex> guard(threadQueuesMutex_);
+        threadQueues_.push_back(queue);
+        threadQueuesChanged_ = true;
+
+        // first free slot of list read by crash handler
+        std::size_t count = crashQueueCount_.load(std::memory_order_relaxed);
+        std::size_t slot = 0;
+        while (slot < count && crashQueues_[slot].load(std::memory_order_relaxed))
+            ++slot;
+
+        if (slot < crashQueues_.size())
+        {
+            crashQueues_[slot].store(queue.get(), std::memory_order_release);
+
+            if (slot == count)
+                crashQueueCount_.store(count + 1, std::memory_order_release);
+        }
+
+        return queue->queue;
+    }
+
+    SLOG_INLINE void Logger::OpenFileIfNeeded(const LogMsg * time)
+    {
+        bool openFile = !file_.IsOpen();
+        bool nextPart = false;
 
         if (!openFile && IsOptionSet(OPTION_FILE_ROLLING) && time)
         {
-            std::time_t tmpTime = time->GetCTime();
-            std::tm * tmpTm = std::localtime(&tmpTime);
-            std::tm * tmpCurrTm = std::localtime(&fileOpenTime_);
+            timeCache_.Update(time->GetCTime());
 
-            if (tmpTm && tmpCurrTm && tmpTm->tm_mday != tmpCurrTm->tm_mday)
+            if (timeCache_.GetDay() != fileOpenDay_)
                 openFile = true;
+        }
+
+        if (!openFile && time)
+        {
+            std::uint64_t rollBytes = rollBytes_;
+            unsigned int rollMinutes = rollMinutes_;
+
+            // pending (not yet written) lines count too
+            if (rollBytes && file_.GetSize() + file_.GetBuffer().size() >= rollBytes)
+                nextPart = true;
+
+            if (rollMinutes && time->GetCTime() - fileOpenTime_ >= std::time_t(rollMinutes) * 60)
+                nextPart = true;
 
-            delete tmpTm;
-            delete tmpCurrTm;
+            openFile = nextPart;
         }
 
         if (openFile)
-            ReopenFile();
+            ReopenFile(nextPart);
     }
 
-    void Logger::ReopenFile()
+    SLOG_INLINE void Logger::ReopenFile(bool nextPart)
     {
-        if (file_.is_open())
-            file_.close();
+        auto start = std::chrono::steady_clock::now();
+
+        // lines rendered so far belong to old file
+        WriteRenderedToFile();
+        file_.Close();
 
         fileOpenTime_ = std::time(nullptr);
 
-        std::tm * tmpCurrTm = std::localtime(&fileOpenTime_);
+        std::tm tmpCurrTm;
+        memset(&tmpCurrTm, 0, sizeof(tmpCurrTm));
+        LocalTime(fileOpenTime_, tmpCurrTm);
+
+        int day = (tmpCurrTm.tm_year + 1900) * 1000 + tmpCurrTm.tm_yday;
+        fileIndex_ = nextPart && day == fileOpenDay_ ? fileIndex_ + 1 : 0;
+        fileOpenDay_ = day;
 
         char date[12];
         memset(date, 0, sizeof(date));
-        std::strftime(date, sizeof(date), "_%Y_%m_%d", tmpCurrTm);
+        std::strftime(date, sizeof(date), "_%Y_%m_%d", &tmpCurrTm);
+
+        file_.SetCompressed(IsOptionSet(OPTION_FILE_COMPRESSION));
+        file_.SetMapped(IsOptionSet(OPTION_FILE_MMAP));
+        file_.SetAsync(IsOptionSet(OPTION_FILE_ASYNC_IO), IsOptionSet(OPTION_FILE_DIRECT_IO));
+        // binary records are not lines - nothing to index
+        file_.SetIndexed(IsOptionSet(OPTION_FILE_INDEX) && !IsOptionSet(OPTION_FILE_BINARY));
+
+        // next parts of the same day: <name>_YYYY_MM_DD_N.<ext>
+        auto partFileName = [&] (int index) -> std::string
+        {
+            std::string name = fileName_;
+            name += date;
+            if (index > 0)
+                name += "_" + std::to_string(index);
+            name += "." + fileExtension_;
+
+            if (IsOptionSet(OPTION_FILE_COMPRESSION) && LogFileSink::CanCompress())
+                name += ".gz";
 
-        delete tmpCurrTm;
+            return name;
+        };
 
-        std::string destFileName = fileName_;
-        destFileName += date;
-        destFileName += "." + fileExtension_;
+        std::uint64_t rollBytes = rollBytes_;
 
-        file_.open(destFileName, std::ios_base::app);
+        // first open of the day - continue with last existing part (e.g. after restart)
+        if (!nextPart && (rollBytes || rollMinutes_))
+        {
+            struct stat st;
+            while (stat(partFileName(fileIndex_ + 1).c_str(), &st) == 0)
+                ++fileIndex_;
+        }
+
+        std::string destFileName;
+
+        while (true)
+        {
+            destFileName = partFileName(fileIndex_);
 
-        file_ << std::setfill('0') << std::endl << separator_ << std::endl << std::endl;
+            if (!file_.Open(destFileName))
+            {
+                WriteToStdOut("can't open log file %s", destFileName.c_str());
+                return;
+            }
+
+            // skip filled part
+            if (!rollBytes || file_.GetSize() < rollBytes)
+                break;
+
+            ++fileIndex_;
+        }
+
+        housekeeper_.Notify(fileName_, fileExtension_, destFileName);
+
+        std::string & buffer = file_.GetBuffer();
+        binaryFile_ = IsOptionSet(OPTION_FILE_BINARY);
+        fileFormat_ = outputFormat_;
+
+        if (binaryFile_)
+            binaryEncoder_.StartSession(buffer, separator_);
+        else if (fileFormat_ == SLOG_FORMAT_TEXT)
+        {
+            // structured formats get no separator - every line has to stay parseable
+            buffer += '\n';
+            buffer += separator_;
+            buffer += "\n\n";
+        }
+
+        file_.Flush();
+
+        rollovers_.Add();
+        rolloverTime_.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
     }
 
-    void Logger::WriteToStdOut(const std::string & str)
+    SLOG_INLINE void Logger::WriteToStdOut(const std::string & str)
     {
         WriteToStdOut(str.c_str());
     }
 
-    void Logger::WriteToStdOut(const char * str, ...)
+    SLOG_INLINE void Logger::WriteToStdOut(const char * str, ...)
     {
         char * buffer = nullptr;
 
@@ -225,9 +627,10 @@ namespace siof
 
         try
         {
-            buffer = new char[strlen(str) + 1024];
+            std::size_t size = strlen(str) + 1024;
+            buffer = new char[size];
 
-            vsprintf(buffer, str, lst);
+            vsnprintf(buffer, size, str, lst);
 
             std::cout << buffer << std::endl;
         }
@@ -239,50 +642,530 @@ namespace siof
         va_end(lst);
 
         if (buffer != nullptr)
-            delete buffer;
+            delete [] buffer;
     }
 
-    void Logger::LogWriter()
+    SLOG_INLINE void Logger::LogWriter()
     {
-        closing_ = false;
-        bool justStarted = true;
-        LoggerMsgList localList;
+        writerId_ = std::this_thread::get_id();
+
+        PlaceWriter();
 
         while (true)
         {
-            dataMutex_.lock();
-            if (!closing_ && queued_.empty())
+            // process is dying - crash handler writes the rest, nothing may be touched meanwhile
+            while (crashing_)
+            {
+                writerParked_ = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(SLOG_WRITER_IDLE_WAIT));
+            }
+
+            std::size_t count = CollectBatch();
+
+            if (!count)
             {
-                dataMutex_.unlock();
+                // storm is over (or logger closes) - report collapsed repeats
+                if (repeats_ && (closing_ || std::chrono::system_clock::now() - repeatsSince_ >= std::chrono::milliseconds(SLOG_REPEAT_REPORT_INTERVAL)))
+                {
+                    WriteBatch();
+                    continue;
+                }
+
+                if (closing_)
+                    break;
 
-                std::unique_lock<std::mutex> lock(logMutex_);
-                canLog_.wait(lock);
+                {
+                    // nothing new - write lines waiting longer than flush interval
+                    std::lock_guard<std::mutex> guard(fileMutex_);
+                    file_.Commit(false);
+                }
 
-                dataMutex_.lock();
+                WaitForMessages();
+                continue;
             }
 
-            localList.swap(queued_);
+            WriteBatch();
 
-            dataMutex_.unlock();
+            // queues drained - batching thread sleeps till next interval even if new messages came meanwhile
+            if (count < SLOG_BATCH_SIZE && waitStrategy_ == SLOG_WAIT_BATCH && !closing_)
+                WaitForMessages();
+        }
 
-            std::lock_guard<std::mutex> guard(fileMutex_);
+        writerRunning_ = false;
+        writerId_ = std::thread::id();
+
+        // nothing more will be written - release waiting producers
+        std::lock_guard<std::mutex> guard(syncMutex_);
+        syncCond_.notify_all();
+    }
+
+    SLOG_INLINE void Logger::PlaceWriter()
+    {
+        LogThreadPlacement placement;
+
+        {
+            std::lock_guard<std::mutex> guard(placementMutex_);
+            placement = writerPlacement_;
+        }
+
+        std::string error;
+        if (!placement.ApplyToCurrentThread(error))
+            WriteToStdOut("logging thread placement failed - " + error);
+
+        if (!placement.localMemory)
+            return;
+
+        // buffers allocated so far (by other threads, before pinning) are allocated again from local node
+        std::vector<LogMsg *> batch;
+        batch.reserve(SLOG_BATCH_SIZE);
+        batch_.swap(batch);
 
-            std::for_each(localList.begin(), localList.end(), [this] (std::shared_ptr<LogMsg> &p) -> void
-                                                                {
-                                                                    OpenFileIfNeeded(p.get());
-                                                                    file_ << *p;
-                                                                });
+        rendered_ = LogRenderedBatch();
 
-            file_.flush();
+        std::lock_guard<std::mutex> guard(fileMutex_);
+        file_.ReallocateBuffers();
+    }
 
-            localList.clear();
+    SLOG_INLINE void Logger::WaitForMessages()
+    {
+        LogWaitStrategy strategy = waitStrategy_;
 
-            if (closing_)
+        if (strategy != SLOG_WAIT_BATCH)
+        {
+            // message usually comes soon under load - checking queues is much cheaper than sleep and wake-up
+            for (int i = 0; i < SLOG_WRITER_SPIN; ++i)
             {
-                std::lock_guard<std::mutex> lock(dataMutex_);
-                if (queued_.empty())
+                if (HasPending() || closing_)
                     return;
+
+                detail::CpuRelax();
+            }
+        }
+
+        // both return to main loop now and then to write lines waiting for flush interval
+        if (strategy == SLOG_WAIT_SPIN)
+            return;
+
+        if (strategy == SLOG_WAIT_YIELD)
+        {
+            std::this_thread::yield();
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(logMutex_);
+
+        writerSleeping_.store(true, std::memory_order_relaxed);
+
+        // pairs with fence in NotifyWriter - message pushed before producer could see writerSleeping_ is seen here
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool ready = strategy == SLOG_WAIT_BATCH ? writerUrgent_.load(std::memory_order_relaxed) : HasPending();
+
+        if (ready || closing_ || crashing_)
+        {
+            writerSleeping_ = false;
+            writerUrgent_ = false;
+            return;
+        }
+
+        // parked thread sleeps until signalled unless something is due without new message
+        std::chrono::milliseconds timeout(batchInterval_.load());
+        bool timed = strategy == SLOG_WAIT_BATCH || GetParkTimeout(timeout);
+
+        writerIdle_ = true;
+
+        if (!timed)
+        {
+            canLog_.wait(lock, [this] () -> bool { return !writerSleeping_; });
+            wakeups_.Add();
+        }
+        else if (canLog_.wait_for(lock, timeout, [this] () -> bool { return !writerSleeping_; }))
+            wakeups_.Add();
+        else
+            idleTimeouts_.Add();
+
+        // pairs with crash handler: it sees thread still idle or thread sees crashing_ in main loop
+        writerIdle_ = false;
+
+        writerSleeping_ = false;
+        writerUrgent_ = false;
+    }
+
+    SLOG_INLINE bool Logger::GetParkTimeout(std::chrono::milliseconds & timeout)
+    {
+        bool due = false;
+        timeout = std::chrono::milliseconds::max();
+
+        {
+            std::lock_guard<std::mutex> guard(fileMutex_);
+
+            std::chrono::steady_clock::time_point deadline;
+            if (file_.GetFlushDeadline(deadline))
+            {
+                timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                due = true;
+            }
+        }
+
+        if (repeats_)
+        {
+            std::chrono::system_clock::time_point deadline = repeatsSince_ + std::chrono::milliseconds(SLOG_REPEAT_REPORT_INTERVAL);
+            timeout = std::min(timeout, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::system_clock::now()));
+            due = true;
+        }
+
+        // cast rounds down - wake up after deadline, not right before it
+        if (due)
+            timeout = std::max(timeout, std::chrono::milliseconds(0)) + std::chrono::milliseconds(1);
+
+        return due;
+    }
+
+    SLOG_INLINE bool Logger::HasPending() const
+    {
+        if (threadQueuesChanged_.load(std::memory_order_relaxed) || !queue_->Empty())
+            return true;
+
+        for (auto & p : writerQueues_)
+        {
+            if (!p->queue.Empty())
+                return true;
+        }
+
+        return false;
+    }
+
+    SLOG_INLINE std::size_t Logger::CollectBatch()
+    {
+        if (threadQueuesChanged_)
+        {
+            std::lock_guard<std::mutex> guard(threadQueuesMutex_);
+
+            // forget drained queues of finished threads (thread can't push after setting abandoned flag)
+            threadQueues_.erase(std::remove_if(threadQueues_.begin(), threadQueues_.end(), [this] (const std::shared_ptr<LogThreadQueue> & p) -> bool
+                                                {
+                                                    if (!p->abandoned || !p->queue.Empty())
+                                                        return false;
+
+                                                    std::size_t count = crashQueueCount_.load(std::memory_order_relaxed);
+                                                    for (std::size_t i = 0; i < count; ++i)
+                                                    {
+                                                        if (crashQueues_[i].load(std::memory_order_relaxed) == p.get())
+                                                            crashQueues_[i].store(nullptr, std::memory_order_release);
+                                                    }
+
+                                                    retiredEnqueued_.Add(p->queue.GetPushed());
+                                                    return true;
+                                                }), threadQueues_.end());
+
+            writerQueues_ = threadQueues_;
+            threadQueuesChanged_ = false;
+        }
+
+        std::size_t depth = queue_->GetSize();
+        for (auto & p : writerQueues_)
+            depth += p->queue.GetSize();
+
+        queueDepthPeak_.Max(depth);
+
+        queuePeeked_ = queue_->Peek(batch_, SLOG_BATCH_SIZE);
+        std::size_t count = queuePeeked_;
+
+        writerPeeked_.resize(writerQueues_.size());
+
+        auto byTime = [] (const LogMsg * a, const LogMsg * b) -> bool { return a->GetTime() < b->GetTime(); };
+
+        for (std::size_t i = 0; i < writerQueues_.size(); ++i)
+        {
+            std::size_t start = batch_.size();
+
+            writerPeeked_[i] = writerQueues_[i]->queue.Peek(batch_, SLOG_BATCH_SIZE);
+            count += writerPeeked_[i];
+
+            if (writerPeeked_[i] == 0)
+            {
+                if (writerQueues_[i]->abandoned)
+                    threadQueuesChanged_ = true;
+
+                continue;
             }
+
+            // every queue is already ordered by time so merge is enough
+            std::inplace_merge(batch_.begin(), batch_.begin() + start, batch_.end(), byTime);
+        }
+
+        return count;
+    }
+
+    SLOG_INLINE void Logger::WriteBatch()
+    {
+        std::lock_guard<std::mutex> guard(fileMutex_);
+
+        bool flush = false;
+        bool dispatch = !dispatcher_.IsEmpty();
+
+        rendered_.Clear();
+        renderedToFile_ = 0;
+
+        if (batch_.empty())
+            WriteRepeats(dispatch);
+        else
+        {
+            batches_.Add();
+            batchSizes_.Add(batch_.size());
+        }
+
+        bool collapse = IsOptionSet(OPTION_COLLAPSE_REPEATS);
+
+        std::size_t recorderCapacity = recorderCapacity_;
+        if (recorderCapacity != recorder_.GetCapacity())
+            recorder_.SetCapacity(recorderCapacity);
+
+        LogLevel recordLevel = recorderCapacity ? recordLevel_.load() : SLOG_LEVEL_NONE;
+
+        std::uint64_t dropped = dropped_;
+        if (dropped != droppedReported_)
+        {
+            droppedMsg_.Set(SLOG_LEVEL_WARNING, std::to_string(dropped - droppedReported_) + " messages dropped (log queue full)");
+            batch_.push_back(&droppedMsg_);
+            droppedReported_ = dropped;
+        }
+
+        for (LogMsg * p : batch_)
+        {
+            flush = flush || flushLevels_[p->GetLogLevel()];
+
+            std::shared_ptr<LogMsgSync> sync = p->TakeSync();
+            if (sync)
+            {
+                syncWaiters_.push_back(sync);
+                flush = true;
+            }
+
+            // flight recorder keeps low levels in memory only - trigger level writes them before itself
+            if (p->GetLogLevel() < recordLevel && p != &droppedMsg_)
+            {
+                recorder_.Add(*p);
+                recordedCount_.Add();
+                continue;
+            }
+
+            if (recorder_.GetCount() && recorderTriggers_[p->GetLogLevel()])
+                WriteRecorded(dispatch);
+
+            if (collapse && lastMsgValid_ && p->IsRepeatOf(lastMsg_))
+            {
+                if (!repeats_)
+                    repeatsSince_ = p->GetTime();
+
+                ++repeats_;
+                repeatsCount_.Add();
+                repeatsLast_ = p->GetTime();
+
+                // long storm is reported periodically
+                if (repeatsLast_ - repeatsSince_ >= std::chrono::milliseconds(SLOG_REPEAT_REPORT_INTERVAL))
+                    WriteRepeats(dispatch);
+
+                continue;
+            }
+
+            WriteRepeats(dispatch);
+            WriteMsg(*p, dispatch);
+
+            // generated line was never enqueued
+            if (p != &droppedMsg_)
+                writtenLevels_[p->GetLogLevel()].Add();
+
+            // copy reuses buffers of previous one
+            lastMsgValid_ = collapse && p != &droppedMsg_;
+            if (lastMsgValid_)
+                lastMsg_ = *p;
+        }
+
+        // everything is rendered/encoded - slots go back before any I/O,
+        // so stalled disk or sink doesn't hold queue space
+        queue_->Release(queuePeeked_);
+
+        for (std::size_t i = 0; i < writerQueues_.size(); ++i)
+            writerQueues_[i]->queue.Release(writerPeeked_[i]);
+
+        batch_.clear();
+
+        WriteRenderedToFile();
+        file_.Commit(flush);
+
+        if (!syncWaiters_.empty())
+        {
+            file_.Sync();
+
+            for (auto & sync : syncWaiters_)
+                MarkWritten(sync);
+
+            syncWaiters_.clear();
+        }
+
+        if (dispatch)
+            dispatcher_.Dispatch(rendered_, flush);
+    }
+
+    SLOG_INLINE void Logger::WriteMsg(LogMsg & msg, bool dispatch)
+    {
+        // may reopen file - lines rendered so far are given to old one
+        OpenFileIfNeeded(&msg);
+
+        if (binaryFile_)
+            binaryEncoder_.Encode(msg, file_.GetBuffer());
+
+        // rendered once for text file and all sinks
+        if (!binaryFile_ || dispatch)
+            rendered_.Add(msg, timeCache_, fileFormat_);
+    }
+
+    SLOG_INLINE void Logger::WriteRepeats(bool dispatch)
+    {
+        if (!repeats_)
+            return;
+
+        repeatsMsg_.Set(lastMsg_.GetLogLevel(), "previous message repeated " + std::to_string(repeats_) + (repeats_ == 1 ? " time" : " times"));
+        repeatsMsg_.SetCategory(lastMsg_.GetCategory());
+        repeatsMsg_.SetTime(repeatsLast_);
+        repeats_ = 0;
+
+        WriteMsg(repeatsMsg_, dispatch);
+    }
+
+    SLOG_INLINE void Logger::WriteRecorded(bool dispatch)
+    {
+        recorded_.clear();
+        recorder_.ForEach([this] (LogMsg & msg) -> void { recorded_.push_back(&msg); });
+
+        // thread queues are merged per batch - messages kept from different batches may be out of order
+        std::stable_sort(recorded_.begin(), recorded_.end(), [] (const LogMsg * a, const LogMsg * b) -> bool { return a->GetTime() < b->GetTime(); });
+
+        WriteRepeats(dispatch);
+
+        for (LogMsg * p : recorded_)
+            WriteMsg(*p, dispatch);
+
+        // kept messages came between last written message and next one
+        lastMsgValid_ = false;
+
+        recorder_.Clear();
+        recorderDumps_.Add();
+    }
+
+    SLOG_INLINE void Logger::WriteRenderedToFile()
+    {
+        // binary file got records instead (lines are rendered only for sinks)
+        if (!binaryFile_)
+            file_.Write(rendered_, renderedToFile_, rendered_.GetCount());
+
+        renderedToFile_ = rendered_.GetCount();
+    }
+
+    SLOG_INLINE void Logger::WaitForSync(const LogMsgSync & sync)
+    {
+        std::unique_lock<std::mutex> lock(syncMutex_);
+
+        // timeout only rechecks writerRunning_ in case logging thread stopped without notification
+        while (!sync.written && writerRunning_)
+            syncCond_.wait_for(lock, std::chrono::milliseconds(SLOG_WRITER_IDLE_WAIT));
+    }
+
+    SLOG_INLINE void Logger::MarkWritten(const std::shared_ptr<LogMsgSync> & sync)
+    {
+        if (!sync)
+            return;
+
+        std::lock_guard<std::mutex> guard(syncMutex_);
+
+        sync->written = true;
+        syncCond_.notify_all();
+    }
+
+    SLOG_INLINE void Logger::WriteOnCrash()
+    {
+        // logging thread owns file buffers, current batch, flight recorder and removes thread queues -
+        // wait until it stops or waits for messages (unless it's the crashing one)
+        crashing_ = true;
+
+        bool writerStopped = IsWriterThread() || !writerRunning_ || writerParked_ || writerIdle_;
+
+        for (int i = 0; i < SLOG_CRASH_WRITER_WAIT && !writerStopped; ++i)
+        {
+            detail::SleepSafe(1);
+            writerStopped = !writerRunning_ || writerParked_ || writerIdle_;
+        }
+
+        // still working (e.g. blocked in write) - nothing is written rather than racing it
+        if (!writerStopped)
+            return;
+
+        // oldest data first: pending file data, lines of current batch, queued messages
+        file_.EmergencyFlush();
+
+        // queued messages can be written only as text
+        if (binaryFile_)
+            return;
+
+        const std::string & text = rendered_.GetText();
+        if (renderedToFile_ < rendered_.GetCount())
+        {
+            std::size_t begin = rendered_.GetLine(renderedToFile_).begin;
+            file_.EmergencyWrite(text.data() + begin, text.size() - begin);
+        }
+
+        long utcOffset = timeCache_.GetUtcOffset();
+
+        auto writeMsg = [&] (const LogMsg & msg) -> void
+        {
+            char line[SLOG_CRASH_LINE_SIZE];
+
+            LogTimeCache::RenderSafe(msg.GetTime(), utcOffset, line);
+            std::size_t size = SLOG_TIME_SIZE;
+            line[size++] = ' ';
+
+            auto append = [&] (const char * str) -> void
+            {
+                for (; *str && size < sizeof(line) - 1; ++str)
+                    line[size++] = *str;
+            };
+
+            append(LogMsg::GetLogLevelStr(msg.GetLogLevel()));
+
+            if (msg.GetCategory())
+            {
+                append("[");
+                append(msg.GetCategory());
+                append("] ");
+            }
+
+            if (msg.GetFormat())
+                size += LogArgs::FormatSafe(msg.GetFormat(), msg.GetArgs().data(), msg.GetArgs().size(), line + size, sizeof(line) - 1 - size);
+            else
+            {
+                std::size_t msgSize = std::min(msg.GetMsg().size(), sizeof(line) - 1 - size);
+                memcpy(line + size, msg.GetMsg().data(), msgSize);
+                size += msgSize;
+            }
+
+            line[size++] = '\n';
+            file_.EmergencyWrite(line, size);
+        };
+
+        // context kept by flight recorder
+        recorder_.ForEach(writeMsg);
+
+        // messages of last batch may be still in queues - they are written again
+        queue_->ForEachPending(writeMsg);
+
+        // queue in list is kept alive by threadQueues_ - only stopped logging thread removes it
+        std::size_t count = crashQueueCount_.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            LogThreadQueue * queue = crashQueues_[i].load(std::memory_order_acquire);
+            if (queue)
+                queue->queue.ForEachPending(writeMsg);
         }
     }
 }
@@ -21,35 +21,128 @@
 #include <array>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <ctime>
-#include <fstream>
-#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
+#include "logConfig.h"
+#include "logBinary.h"
+#include "logCategory.h"
+#include "logFileSink.h"
+#include "logHousekeeper.h"
 #include "logMsg.h"
+#include "logQueue.h"
+#include "logRateLimit.h"
+#include "logRecorder.h"
+#include "logSink.h"
+#include "logSinks.h"
+#include "logStats.h"
+#include "logThread.h"
 
 namespace siof
 {
     #define SLOG_SEP_DEFAULT    "##########################################################################\n"\
                                 "##########################################################################"
 
-    typedef std::list<std::shared_ptr<LogMsg> > LoggerMsgList;
+    /// max messages written by logging thread in one batch
+    #define SLOG_BATCH_SIZE         1024
+    /// recheck period (in milliseconds) of logging thread stopped by crash handler and of producers waiting for sync message
+    #define SLOG_WRITER_IDLE_WAIT   10
+    /// queue checks of idle logging thread before it yields / parks
+    #ifndef SLOG_WRITER_SPIN
+    #define SLOG_WRITER_SPIN        64
+    #endif
+    /// default interval (in milliseconds) of SLOG_WAIT_BATCH
+    #define SLOG_WRITER_BATCH_INTERVAL  20
+    /// max time (in milliseconds) collapsed repeats wait for "previous message repeated" line (OPTION_COLLAPSE_REPEATS)
+    #ifndef SLOG_REPEAT_REPORT_INTERVAL
+    #define SLOG_REPEAT_REPORT_INTERVAL 1000
+    #endif
+    /// default capacity of per thread queues (OPTION_THREAD_BUFFERS)
+    #define SLOG_THREAD_QUEUE_DEFAULT_CAPACITY  1024
+    /// max per thread queues seen by crash handler at once (messages in queues of further threads are not written on crash)
+    #ifndef SLOG_CRASH_THREAD_QUEUES
+    #define SLOG_CRASH_THREAD_QUEUES    256
+    #endif
 
     enum LoggerOptions
     {
         OPTION_FILE_ROLLING     = 0,
+        /// every producer thread gets own single producer queue,
+        /// logging thread merges them by message time
+        OPTION_THREAD_BUFFERS   = 1,
+        /// log file is written through memory mapping (POSIX only, applied on file (re)open)
+        OPTION_FILE_MMAP        = 2,
+        /// log file contains binary records (see LogBinaryEncoder, decode with logdecode tool)
+        /// applied on file (re)open
+        OPTION_FILE_BINARY      = 3,
+        /// log file is gzip compressed (".gz" is added to file name), needs build with SLOG_WITH_ZLIB
+        /// applied on file (re)open
+        OPTION_FILE_COMPRESSION = 4,
+        /// consecutive identical messages (level, category, text) are written once and followed by
+        /// "previous message repeated N times" line (when other message comes or every SLOG_REPEAT_REPORT_INTERVAL)
+        OPTION_COLLAPSE_REPEATS = 5,
+        /// log file is written with asynchronous io_uring writes (Linux 5.6+, plain writes when not available),
+        /// logging thread doesn't wait for slow disk. Applied on file (re)open, ignored with OPTION_FILE_MMAP
+        /// and OPTION_FILE_COMPRESSION
+        OPTION_FILE_ASYNC_IO    = 6,
+        /// with OPTION_FILE_ASYNC_IO log file is opened with O_DIRECT (bypasses page cache)
+        /// applied on file (re)open
+        OPTION_FILE_DIRECT_IO   = 7,
+        /// text log file gets sidecar time index "<file>.idx" (query it with logquery tool)
+        /// applied on file (re)open, ignored with OPTION_FILE_BINARY and OPTION_FILE_COMPRESSION
+        OPTION_FILE_INDEX       = 8,
 
         OPTIONS_COUNT
     };
 
+    /// what producer does when queue is full
+    enum LogOverflowPolicy
+    {
+        /// waits for free slot (default), message logged on logging thread (e.g. by callback sink) is dropped
+        SLOG_OVERFLOW_BLOCK             = 0,
+        /// new message is dropped
+        SLOG_OVERFLOW_DROP_NEWEST       = 1,
+        /// oldest message not yet taken by logging thread is dropped to make place
+        SLOG_OVERFLOW_DROP_OLDEST       = 2,
+        /// messages below overflow level are dropped, others wait
+        SLOG_OVERFLOW_DROP_BELOW_LEVEL  = 3
+    };
+
+    /// how idle logging thread waits for new messages
+    enum LogWaitStrategy
+    {
+        /// spins shortly, then sleeps until woken - producers signal only parked thread (default)
+        SLOG_WAIT_PARK          = 0,
+        /// busy spin, never sleeps - lowest latency, needs dedicated core
+        SLOG_WAIT_SPIN          = 1,
+        /// spins shortly, then yields CPU between checks, never sleeps
+        SLOG_WAIT_YIELD         = 2,
+        /// writes batch once per interval - woken earlier only by full queue or message with flush/sync level
+        SLOG_WAIT_BATCH         = 3
+    };
+
+    /// per thread queue registered in logger (OPTION_THREAD_BUFFERS)
+    struct LogThreadQueue
+    {
+        explicit LogThreadQueue(std::size_t capacity) : queue(capacity, true), abandoned(false) {}
+
+        LogQueue queue;
+        /// set when owning thread exits - logging thread drops queue once it's drained
+        std::atomic<bool> abandoned;
+    };
+
+    typedef std::vector<std::shared_ptr<LogThreadQueue> > LogThreadQueueList;
+
     class Logger
     {
     public:
         /// only creates logger
-        Logger() : closing_(false), minLogLevel_(SLOG_LEVEL_NONE), separator_(SLOG_SEP_DEFAULT), fileOpenTime_(0) {}
+        Logger();
         /// dtor
         ~Logger();
 
@@ -69,40 +162,466 @@ namespace siof
 
         void Close();
 
-        void AddMessage(LogLevel logLevel, const std::string & msg);
+        /// returns if message with given level passes minimal log level (cheap enough for every call site)
+        bool IsLevelEnabled(LogLevel logLevel) const
+        {
+            return minLogLevel_.load(std::memory_order_relaxed) <= logLevel;
+        }
+
+        void AddMessage(LogLevel logLevel, const std::string & msg)
+        {
+            if (!IsLevelEnabled(logLevel))
+                return;
+
+            std::uint64_t suppressed;
+            if (IsRateLimited(suppressed, msg.data(), msg.size()))
+                return;
+
+            // count of suppressed messages is stored as field - message is queued for formatting then
+            if (suppressed)
+            {
+                EnqueueFormat(nullptr, suppressed, logLevel, "%s", msg);
+                return;
+            }
+
+            try
+            {
+                Enqueue(logLevel, [&] (LogMsg & slot) -> void { slot.Set(logLevel, msg); });
+            }
+            catch (std::exception & e)
+            {
+                WriteToStdOut(e.what());
+            }
+        }
+
         void AddMessage(LogLevel logLevel, const char * fmt, ...);
 
+        /// printf like logging with formatting deferred to logging thread.
+        /// Only fmt pointer and args are queued, so fmt has to be string literal.
+        /// Fields created by kv are rendered after text (see SetOutputFormat).
+        template <std::size_t N, typename... Args>
+        void Log(LogLevel logLevel, const char (&fmt)[N], const Args &... args)
+        {
+            std::uint64_t suppressed;
+            if (IsLevelEnabled(logLevel) && !IsRateLimited(suppressed, fmt))
+                EnqueueFormat(nullptr, suppressed, logLevel, fmt, args...);
+        }
+
+        /// mutable buffer would be read by logging thread after it changes or goes out of scope -
+        /// format it with AddMessage instead
+        template <std::size_t N, typename... Args>
+        void Log(LogLevel logLevel, char (&fmt)[N], const Args &... args) = delete;
+
+        /// as Log, message is written with category name and only category level is checked
+        template <std::size_t N, typename... Args>
+        void Log(const LogCategory & category, LogLevel logLevel, const char (&fmt)[N], const Args &... args)
+        {
+            std::uint64_t suppressed;
+            if (category.IsLevelEnabled(logLevel) && !IsRateLimited(suppressed, fmt))
+                EnqueueFormat(&category, suppressed, logLevel, fmt, args...);
+        }
+
+        template <std::size_t N, typename... Args>
+        void Log(const LogCategory & category, LogLevel logLevel, char (&fmt)[N], const Args &... args) = delete;
+
+        /// as Log, limited by own token bucket instead of SetRateLimit (see SLOG_LIMITED)
+        template <std::size_t N, typename... Args>
+        void LogLimited(LogRateLimit & limit, std::int64_t interval, unsigned int burst, LogLevel logLevel,
+                        const char (&fmt)[N], const Args &... args)
+        {
+            std::uint64_t suppressed;
+            if (IsLevelEnabled(logLevel) && limit.Allow(interval, burst, suppressed))
+                EnqueueFormat(nullptr, suppressed, logLevel, fmt, args...);
+        }
+
+        template <std::size_t N, typename... Args>
+        void LogLimited(LogRateLimit & limit, std::int64_t interval, unsigned int burst, LogLevel logLevel,
+                        char (&fmt)[N], const Args &... args) = delete;
+
         void SetOption(LoggerOptions option, bool enabled);
 
-        bool IsOptionSet(LoggerOptions option);
+        bool IsOptionSet(LoggerOptions option) const
+        {
+            return options_[option].load(std::memory_order_relaxed);
+        }
 
         void SetMinimalLogLevel(LogLevel logLevel);
 
-        LogLevel GetMinimalLogLevel();
+        LogLevel GetMinimalLogLevel() const
+        {
+            return minLogLevel_.load(std::memory_order_relaxed);
+        }
+
+        /// returns handle of named category ("net.http" is subcategory of "net"), created when needed.
+        /// Handle lives as long as logger - keep it at call site, e.g. in function static.
+        /// Category without own level inherits level of its parent, top level ones minimal log level.
+        LogCategory & GetCategory(const std::string & name);
+        /// sets minimal level of category and its subcategories without own level (all handles at once)
+        void SetCategoryLevel(const std::string & name, LogLevel logLevel);
+        /// category inherits level of its parent again
+        void ResetCategoryLevel(const std::string & name);
+
+        /// sets max count of messages waiting for logging thread
+        /// works only when logging thread is not working
+        void SetQueueCapacity(std::size_t capacity);
+        /// sets capacity of per thread queues created from now on (OPTION_THREAD_BUFFERS)
+        void SetThreadQueueCapacity(std::size_t capacity);
+        /// sets what happens with message when queue is full, logLevel is used by SLOG_OVERFLOW_DROP_BELOW_LEVEL.
+        /// Logging thread writes "N messages dropped" line after drops.
+        void SetOverflowPolicy(LogOverflowPolicy policy, LogLevel logLevel = SLOG_LEVEL_NONE);
+        /// sets how idle logging thread waits for messages, intervalMs is used by SLOG_WAIT_BATCH
+        void SetWaitStrategy(LogWaitStrategy strategy, unsigned int intervalMs = SLOG_WRITER_BATCH_INTERVAL);
+        /// limits every kind of message (Log format string, AddMessage text) to ratePerSecond messages per second
+        /// with bursts up to burst messages (0 rate - no limit). Count of suppressed messages is added
+        /// to next logged message of the kind as "suppressed" field.
+        void SetRateLimit(double ratePerSecond, unsigned int burst);
+        /// returns count of messages dropped by overflow policy
+        std::uint64_t GetDroppedCount() const { return dropped_; }
+
+        /// returns snapshot of self-instrumentation counters (cheap enough to be scraped periodically)
+        LogStats GetStats() const;
+
+        /// rendered lines are written to file when at least bytes are pending
+        /// or oldest pending line waits intervalMs (0 - write after every batch)
+        void SetFlushPolicy(std::size_t bytes, unsigned int intervalMs);
+        /// besides daily rolling (OPTION_FILE_ROLLING) starts next file of the day
+        /// when file has maxBytes or was opened intervalMinutes ago (0 - disabled)
+        void SetRollingPolicy(std::uint64_t maxBytes, unsigned int intervalMinutes);
+        /// keeps at most maxFiles log files / maxBytes in total (0 - no limit)
+        /// old files are removed by background housekeeping thread
+        void SetRetention(std::size_t maxFiles, std::uint64_t maxBytes);
+
+        /// sets if message with given level forces immediate write (by default ERROR, FATAL and EXCEPTION do)
+        void SetFlushLevel(LogLevel logLevel, bool immediate);
+        /// sets if producer of message with given level waits until message is written and synced to disk
+        /// (by default FATAL and EXCEPTION do), other messages stay asynchronous
+        void SetSyncLevel(LogLevel logLevel, bool sync);
+
+        /// flight recorder: messages with level below recordLevel (SLOG_LEVEL_WARNING keeps DEBUG and DEBUG2) are not
+        /// written - last capacity of them are kept in memory and written (in time order) right before message
+        /// with trigger level (see SetRecorderTrigger) or by crash handler. Minimal log level has to let recorded
+        /// levels through. 0 capacity - disabled (default).
+        void SetFlightRecorder(std::size_t capacity, LogLevel recordLevel = SLOG_LEVEL_WARNING);
+        /// sets if message with given level writes messages kept by flight recorder (by default ERROR, FATAL and EXCEPTION do)
+        void SetRecorderTrigger(LogLevel logLevel, bool trigger);
+
+        /// on fatal signal (SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT) writes pending data, messages kept by
+        /// flight recorder and queued messages to log file before process dies (text files only, messages may be repeated,
+        /// queued ones are written in text format without fields). Nothing is written when logging thread doesn't stop
+        /// in SLOG_CRASH_WRITER_WAIT (e.g. blocked in write).
+        /// Returns false if handler can't be enabled.
+        bool EnableCrashHandler(bool enabled);
+
+        /// adds output besides log file - every batch is rendered once and given to all sinks.
+        /// ownThread - sink is written by own thread (LogAsyncSink), so slow output can't stall logging.
+        /// Returns registered sink (pass it to RemoveSink).
+        std::shared_ptr<LogSink> AddSink(const std::shared_ptr<LogSink> & sink, bool ownThread = false);
+        void RemoveSink(const std::shared_ptr<LogSink> & sink);
+
+        /// lines with lower level are not written to log file (other sinks have own levels)
+        void SetFileLevel(LogLevel logLevel);
+
+        /// sets how lines of text file and sinks are rendered (text, logfmt, JSON Lines), applied on file (re)open.
+        /// Binary file keeps fields, logdecode renders them in any format.
+        void SetOutputFormat(LogFormat format);
+
+        /// logging thread placement (Linux only, applied when logging thread starts):
+        /// sets name shown by top/perf/gdb (SLOG_WRITER_THREAD_NAME by default)
+        void SetWriterName(const std::string & name);
+        /// pins logging thread to cpus (empty - any CPU), localMemory - its buffers are allocated
+        /// on NUMA node it runs on
+        void SetWriterAffinity(const std::vector<int> & cpus, bool localMemory = true);
+        /// sets scheduling policy (SCHED_* value), static priority (SCHED_FIFO / SCHED_RR) and nice value
+        void SetWriterScheduling(int policy, int priority, int niceValue = 0);
 
     private:
+        friend class LogCrashHandler;
 
         /// function to open/reopen file if needed
         void OpenFileIfNeeded(const LogMsg * time);
-        void ReopenFile();
+        /// opens file for current day, nextPart - next file of the same day (size/interval rolling)
+        void ReopenFile(bool nextPart = false);
 
         void WriteToStdOut(const std::string & str);
         void WriteToStdOut(const char * str, ...);
 
+        /// returns true if message of kind given by key (see LogRateLimit::GetSlot) is refused by SetRateLimit,
+        /// suppressed - messages of the kind refused since previous allowed one
+        template <typename... Key>
+        bool IsRateLimited(std::uint64_t & suppressed, const Key &... key)
+        {
+            suppressed = 0;
+
+            std::int64_t interval = rateInterval_.load(std::memory_order_relaxed);
+            if (!interval)
+                return false;
+
+            return !rateLimits_[LogRateLimit::GetSlot(key...)].Allow(interval, rateBurst_.load(std::memory_order_relaxed), suppressed);
+        }
+
+        /// queues not yet formatted message, suppressed - count of rate limited messages added as field
+        template <typename... Args>
+        void EnqueueFormat(const LogCategory * category, std::uint64_t suppressed, LogLevel logLevel, const char * fmt, const Args &... args)
+        {
+            try
+            {
+                if (suppressed)
+                    rateLimited_ += suppressed;
+
+                Enqueue(logLevel, [&] (LogMsg & slot) -> void
+                                    {
+                                        if (suppressed)
+                                            slot.SetFormat(logLevel, fmt, args..., kv("suppressed", suppressed));
+                                        else
+                                            slot.SetFormat(logLevel, fmt, args...);
+
+                                        if (category)
+                                            slot.SetCategory(category->GetName().c_str());
+                                    });
+            }
+            catch (std::exception & e)
+            {
+                WriteToStdOut(e.what());
+            }
+        }
+
+        /// returns if called from logging thread
+        bool IsWriterThread() const
+        {
+            return std::this_thread::get_id() == writerId_.load(std::memory_order_relaxed);
+        }
+
+        /// puts message into calling thread queue or shared queue, producer of message with sync level
+        /// waits until logging thread has written it to disk
+        template <typename Fill>
+        void Enqueue(LogLevel logLevel, Fill fill)
+        {
+            // logging thread (e.g. callback sink) would wait for itself
+            if (!syncLevels_[logLevel].load(std::memory_order_relaxed) || !writerRunning_ || IsWriterThread())
+            {
+                Push(logLevel, fill);
+                return;
+            }
+
+            std::shared_ptr<LogMsgSync> sync(new LogMsgSync());
+
+            if (Push(logLevel, [&] (LogMsg & slot) -> void { fill(slot); slot.SetSync(sync); }))
+                WaitForSync(*sync);
+        }
+
+        /// puts message into queue (full queue is handled by overflow policy), returns false if message was dropped
+        template <typename Fill>
+        bool Push(LogLevel logLevel, Fill fill)
+        {
+            LogQueue & queue = IsOptionSet(OPTION_THREAD_BUFFERS) ? GetThreadQueue() : *queue_;
+
+            while (!queue.TryPush(fill))
+            {
+                // nobody will make place in queue
+                if (!writerRunning_)
+                    return false;
+
+                LogOverflowPolicy policy = overflowPolicy_.load(std::memory_order_relaxed);
+
+                if (policy == SLOG_OVERFLOW_DROP_NEWEST ||
+                    (policy == SLOG_OVERFLOW_DROP_BELOW_LEVEL && logLevel < overflowLevel_.load(std::memory_order_relaxed)))
+                {
+                    ++droppedLevels_[logLevel];
+                    ++dropped_;
+                    NotifyWriter(logLevel, true);
+                    return false;
+                }
+
+                // producer waiting for dropped message must not wait forever
+                if (policy == SLOG_OVERFLOW_DROP_OLDEST && queue.DiscardOldest([this] (LogMsg & msg) -> void
+                                                                                {
+                                                                                    ++droppedLevels_[msg.GetLogLevel()];
+                                                                                    MarkWritten(msg.TakeSync());
+                                                                                }))
+                {
+                    ++dropped_;
+                    continue;
+                }
+
+                // logging thread itself (e.g. callback sink) would wait forever - message is dropped as newest
+                if (IsWriterThread())
+                {
+                    ++droppedLevels_[logLevel];
+                    ++dropped_;
+                    return false;
+                }
+
+                // queue is full - wake logging thread and wait for free slot
+                NotifyWriter(logLevel, true);
+                std::this_thread::yield();
+            }
+
+            NotifyWriter(logLevel, false);
+            return true;
+        }
+
+        /// wakes logging thread after push if it's parked (no syscall while it's busy),
+        /// force - queue is full, wakes also batching thread
+        void NotifyWriter(LogLevel logLevel, bool force)
+        {
+            LogWaitStrategy strategy = waitStrategy_.load(std::memory_order_relaxed);
+
+            if (strategy == SLOG_WAIT_SPIN || strategy == SLOG_WAIT_YIELD)
+                return;
+
+            if (strategy == SLOG_WAIT_BATCH)
+            {
+                if (!force && !flushLevels_[logLevel].load(std::memory_order_relaxed) && !syncLevels_[logLevel].load(std::memory_order_relaxed))
+                    return;
+
+                writerUrgent_.store(true, std::memory_order_relaxed);
+            }
+
+            // pairs with fence in WaitForMessages - either logging thread sees pushed message or we see it parked
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (writerSleeping_.load(std::memory_order_relaxed))
+                WakeWriter();
+        }
+
+        /// wakes parked logging thread
+        void WakeWriter();
+
+        /// waits until logging thread marks message as written (or stops)
+        void WaitForSync(const LogMsgSync & sync);
+        /// marks message as written and wakes waiting producers
+        void MarkWritten(const std::shared_ptr<LogMsgSync> & sync);
+
+        /// crash handler: writes pending data and queued messages with async-signal-safe calls only
+        void WriteOnCrash();
+
+        /// returns unique id for new logger
+        static std::uint64_t NextId();
+
+        /// returns queue owned by calling thread (creates and registers it if needed)
+        LogQueue & GetThreadQueue();
+
         void LogWriter();
 
+        /// logging thread: applies writerPlacement_ to itself
+        void PlaceWriter();
+
+        /// idle logging thread: waits for new messages according to wait strategy
+        void WaitForMessages();
+        /// returns if parked logging thread has to wake up without message (lines waiting for flush interval,
+        /// collapsed repeats report), timeout - time till the first of them
+        bool GetParkTimeout(std::chrono::milliseconds & timeout);
+        /// logging thread: returns if any queue has ready message
+        bool HasPending() const;
+
+        /// takes ready messages from all queues into batch_ (ordered by time)
+        std::size_t CollectBatch();
+
+        /// writes messages from batch_ to file and sinks and gives slots back to queues
+        /// (with empty batch_ writes only pending "previous message repeated" line)
+        void WriteBatch();
+        /// encodes / renders one message of batch
+        void WriteMsg(LogMsg & msg, bool dispatch);
+        /// writes "previous message repeated N times" line for collapsed repeats
+        void WriteRepeats(bool dispatch);
+        /// writes messages kept by flight recorder and forgets them
+        void WriteRecorded(bool dispatch);
+
+        /// gives lines rendered since last call to file
+        void WriteRenderedToFile();
+
         std::atomic<bool> closing_;
+        /// set while logging thread is able to consume messages
+        std::atomic<bool> writerRunning_;
 
         std::array<std::atomic<bool>, OPTIONS_COUNT> options_;
 
         std::atomic<LogLevel> minLogLevel_;
+        LogCategories categories_;
+
+        std::atomic<LogOverflowPolicy> overflowPolicy_;
+        std::atomic<LogLevel> overflowLevel_;
+        /// messages dropped by overflow policy
+        std::atomic<std::uint64_t> dropped_;
+        /// logging thread: dropped_ value already reported in log
+        std::uint64_t droppedReported_;
+        /// logging thread: "N messages dropped" line
+        LogMsg droppedMsg_;
+        std::array<std::atomic<std::uint64_t>, SLOG_LEVEL_COUNT> droppedLevels_;
+
+        /// SetRateLimit state: time between messages (ns, 0 - no limit), burst and buckets of message kinds
+        std::atomic<std::int64_t> rateInterval_;
+        std::atomic<unsigned int> rateBurst_;
+        std::vector<LogRateLimit> rateLimits_;
+        /// messages refused by rate limits (counted when reported with next message)
+        std::atomic<std::uint64_t> rateLimited_;
+
+        /// logging thread: last written message and count of its collapsed repeats (OPTION_COLLAPSE_REPEATS)
+        LogMsg lastMsg_;
+        bool lastMsgValid_;
+        std::uint64_t repeats_;
+        /// time of first / last collapsed repeat
+        LogTimePoint repeatsSince_;
+        LogTimePoint repeatsLast_;
+        LogMsg repeatsMsg_;
+        LogCounter repeatsCount_;
+
+        /// flight recorder settings (applied by logging thread with next batch)
+        std::atomic<std::size_t> recorderCapacity_;
+        std::atomic<LogLevel> recordLevel_;
+        std::array<std::atomic<bool>, SLOG_LEVEL_COUNT> recorderTriggers_;
+        /// logging thread: kept messages and their copy sorted by time for writing
+        LogFlightRecorder recorder_;
+        std::vector<LogMsg *> recorded_;
+        LogCounter recordedCount_;
+        LogCounter recorderDumps_;
+
+        /// logging thread counters (see LogStats)
+        std::array<LogCounter, SLOG_LEVEL_COUNT> writtenLevels_;
+        LogCounter queueDepthPeak_;
+        LogCounter batches_;
+        LogHistogram batchSizes_;
+        LogCounter wakeups_;
+        LogCounter idleTimeouts_;
+        /// parked logging thread woken by producers (updated under logMutex_)
+        LogCounter signals_;
+        /// updated under fileMutex_
+        LogCounter rollovers_;
+        LogCounter rolloverTime_;
+        /// messages pushed to thread queues already removed (under threadQueuesMutex_)
+        LogCounter retiredEnqueued_;
 
         std::condition_variable canLog_;
+        std::atomic<LogWaitStrategy> waitStrategy_;
+        std::atomic<unsigned int> batchInterval_;
+        /// set by logging thread before it parks, cleared by producer which wakes it
+        std::atomic<bool> writerSleeping_;
+        /// SLOG_WAIT_BATCH: message which should not wait for interval was pushed
+        std::atomic<bool> writerUrgent_;
+
+        /// messages waiting for logging thread
+        std::shared_ptr<LogQueue> queue_;
+        /// messages taken from queues by logging thread
+        std::vector<LogMsg *> batch_;
+        /// count of messages in batch_ taken from queue_
+        std::size_t queuePeeked_;
+
+        /// unique logger id - used to find per thread queues
+        const std::uint64_t id_;
+        std::atomic<std::size_t> threadQueueCapacity_;
+        /// queues registered by producer threads
+        LogThreadQueueList threadQueues_;
+        std::atomic<bool> threadQueuesChanged_;
+        mutable std::mutex threadQueuesMutex_;
+        /// logging thread copy of threadQueues_ with count of messages peeked from each
+        LogThreadQueueList writerQueues_;
+        std::vector<std::size_t> writerPeeked_;
+        /// threadQueues_ published for crash handler, which can't lock (written under threadQueuesMutex_).
+        /// Slots are appended and reused, slot of removed queue is cleared before queue is released.
+        std::array<std::atomic<LogThreadQueue *>, SLOG_CRASH_THREAD_QUEUES> crashQueues_;
+        /// used slots of crashQueues_ (only grows)
+        std::atomic<std::size_t> crashQueueCount_;
 
-        ///
-        LoggerMsgList queued_;
-
-        std::mutex dataMutex_;
         std::mutex logMutex_;
         std::mutex fileMutex_;
         std::mutex closeMutex_;
@@ -113,10 +632,168 @@ namespace siof
 
         std::string separator_;
 
-        std::ofstream file_;
+        LogFileSink file_;
+        /// lines of current batch (rendered for text file and sinks)
+        LogRenderedBatch rendered_;
+        /// count of rendered_ lines already given to file
+        std::size_t renderedToFile_;
+        std::atomic<LogFormat> outputFormat_;
+        /// format of opened file (outputFormat_ at open time)
+        LogFormat fileFormat_;
+        LogDispatcher dispatcher_;
+
+        /// levels which force immediate write of whole batch
+        std::array<std::atomic<bool>, SLOG_LEVEL_COUNT> flushLevels_;
+        /// levels which make producer wait for durable write
+        std::array<std::atomic<bool>, SLOG_LEVEL_COUNT> syncLevels_;
+        /// logging thread: waiters for messages of current batch
+        std::vector<std::shared_ptr<LogMsgSync> > syncWaiters_;
+        std::mutex syncMutex_;
+        std::condition_variable syncCond_;
+        std::atomic<bool> crashHandler_;
+        /// set by crash handler - logging thread stops and sets writerParked_
+        std::atomic<bool> crashing_;
+        std::atomic<bool> writerParked_;
+        /// logging thread waits for messages - checks crashing_ after clearing it, before touching anything
+        std::atomic<bool> writerIdle_;
+        /// set by logging thread while it runs (producers compare it with own id)
+        std::atomic<std::thread::id> writerId_;
+        LogThreadPlacement writerPlacement_;
+        std::mutex placementMutex_;
 
         std::time_t fileOpenTime_;
+        /// local day (as returned by LogTimeCache::GetDay) of fileOpenTime_
+        int fileOpenDay_;
+        /// part of the day (size/interval rolling)
+        int fileIndex_;
+
+        std::atomic<std::uint64_t> rollBytes_;
+        std::atomic<unsigned int> rollMinutes_;
+        LogHousekeeper housekeeper_;
+
+        /// logging thread time cache
+        LogTimeCache timeCache_;
+
+        /// if opened file is binary (OPTION_FILE_BINARY at open time)
+        bool binaryFile_;
+        LogBinaryEncoder binaryEncoder_;
     };
 }
 
+/// Logging macros - arguments are evaluated only when message passes both level checks:
+/// SLOG_MIN_LEVEL (compile time, numeric LogLevel value) removes statements below it entirely,
+/// Logger::IsLevelEnabled (runtime) is checked before anything else is done.
+/// Format has to be string literal (see Logger::Log), e.g. SLOG_DEBUG(logger, "user %s", name);
+#ifndef SLOG_MIN_LEVEL
+#define SLOG_MIN_LEVEL          0
+#endif
+
+#define SLOG_LOG(logger, logLevel, ...)                                                 \
+    do                                                                                  \
+    {                                                                                   \
+        if ((logLevel) >= SLOG_MIN_LEVEL && (logger).IsLevelEnabled(logLevel))          \
+            (logger).Log((logLevel), __VA_ARGS__);                                      \
+    }                                                                                   \
+    while (0)
+
+/// statement removed by SLOG_MIN_LEVEL - still type checked (and variables count as used), never executed
+#define SLOG_DISABLED(logger, logLevel, ...)                                            \
+    do                                                                                  \
+    {                                                                                   \
+        if (false)                                                                      \
+            (logger).Log((logLevel), __VA_ARGS__);                                      \
+    }                                                                                   \
+    while (0)
+
+/// category variants check only level of category handle (see Logger::GetCategory), e.g.
+/// static siof::LogCategory & http = logger.GetCategory("net.http"); SLOG_CAT_DEBUG(logger, http, "status %d", status);
+#define SLOG_CAT_LOG(logger, category, logLevel, ...)                                   \
+    do                                                                                  \
+    {                                                                                   \
+        if ((logLevel) >= SLOG_MIN_LEVEL && (category).IsLevelEnabled(logLevel))        \
+            (logger).Log((category), (logLevel), __VA_ARGS__);                          \
+    }                                                                                   \
+    while (0)
+
+#define SLOG_CAT_DISABLED(logger, category, logLevel, ...)                              \
+    do                                                                                  \
+    {                                                                                   \
+        if (false)                                                                      \
+            (logger).Log((category), (logLevel), __VA_ARGS__);                          \
+    }                                                                                   \
+    while (0)
+
+/// logs at most ratePerSecond messages per second (bursts up to burst) from this statement, count of
+/// suppressed ones is added to next logged message as "suppressed" field, e.g.
+/// SLOG_LIMITED(logger, siof::SLOG_LEVEL_ERROR, 10, 20, "connect to %s failed", host);
+#define SLOG_LIMITED(logger, logLevel, ratePerSecond, burst, ...)                       \
+    do                                                                                  \
+    {                                                                                   \
+        static siof::LogRateLimit slogRateLimit;                                        \
+        if ((logLevel) >= SLOG_MIN_LEVEL && (logger).IsLevelEnabled(logLevel))          \
+            (logger).LogLimited(slogRateLimit, siof::LogRateLimit::GetInterval(ratePerSecond), \
+                                (burst), (logLevel), __VA_ARGS__);                      \
+    }                                                                                   \
+    while (0)
+
+#if SLOG_MIN_LEVEL <= 1
+#define SLOG_DEBUG(logger, ...)         SLOG_LOG(logger, siof::SLOG_LEVEL_DEBUG, __VA_ARGS__)
+#define SLOG_CAT_DEBUG(logger, category, ...)       SLOG_CAT_LOG(logger, category, siof::SLOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define SLOG_DEBUG(logger, ...)         SLOG_DISABLED(logger, siof::SLOG_LEVEL_DEBUG, __VA_ARGS__)
+#define SLOG_CAT_DEBUG(logger, category, ...)       SLOG_CAT_DISABLED(logger, category, siof::SLOG_LEVEL_DEBUG, __VA_ARGS__)
+#endif
+
+#if SLOG_MIN_LEVEL <= 2
+#define SLOG_DEBUG2(logger, ...)        SLOG_LOG(logger, siof::SLOG_LEVEL_DEBUG2, __VA_ARGS__)
+#define SLOG_CAT_DEBUG2(logger, category, ...)      SLOG_CAT_LOG(logger, category, siof::SLOG_LEVEL_DEBUG2, __VA_ARGS__)
+#else
+#define SLOG_DEBUG2(logger, ...)        SLOG_DISABLED(logger, siof::SLOG_LEVEL_DEBUG2, __VA_ARGS__)
+#define SLOG_CAT_DEBUG2(logger, category, ...)      SLOG_CAT_DISABLED(logger, category, siof::SLOG_LEVEL_DEBUG2, __VA_ARGS__)
+#endif
+
+#if SLOG_MIN_LEVEL <= 3
+#define SLOG_WARNING(logger, ...)       SLOG_LOG(logger, siof::SLOG_LEVEL_WARNING, __VA_ARGS__)
+#define SLOG_CAT_WARNING(logger, category, ...)     SLOG_CAT_LOG(logger, category, siof::SLOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define SLOG_WARNING(logger, ...)       SLOG_DISABLED(logger, siof::SLOG_LEVEL_WARNING, __VA_ARGS__)
+#define SLOG_CAT_WARNING(logger, category, ...)     SLOG_CAT_DISABLED(logger, category, siof::SLOG_LEVEL_WARNING, __VA_ARGS__)
+#endif
+
+#if SLOG_MIN_LEVEL <= 4
+#define SLOG_ERROR(logger, ...)         SLOG_LOG(logger, siof::SLOG_LEVEL_ERROR, __VA_ARGS__)
+#define SLOG_CAT_ERROR(logger, category, ...)       SLOG_CAT_LOG(logger, category, siof::SLOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define SLOG_ERROR(logger, ...)         SLOG_DISABLED(logger, siof::SLOG_LEVEL_ERROR, __VA_ARGS__)
+#define SLOG_CAT_ERROR(logger, category, ...)       SLOG_CAT_DISABLED(logger, category, siof::SLOG_LEVEL_ERROR, __VA_ARGS__)
+#endif
+
+#if SLOG_MIN_LEVEL <= 5
+#define SLOG_FATAL(logger, ...)         SLOG_LOG(logger, siof::SLOG_LEVEL_FATAL, __VA_ARGS__)
+#define SLOG_CAT_FATAL(logger, category, ...)       SLOG_CAT_LOG(logger, category, siof::SLOG_LEVEL_FATAL, __VA_ARGS__)
+#else
+#define SLOG_FATAL(logger, ...)         SLOG_DISABLED(logger, siof::SLOG_LEVEL_FATAL, __VA_ARGS__)
+#define SLOG_CAT_FATAL(logger, category, ...)       SLOG_CAT_DISABLED(logger, category, siof::SLOG_LEVEL_FATAL, __VA_ARGS__)
+#endif
+
+#if SLOG_MIN_LEVEL <= 6
+#define SLOG_EXCEPTION(logger, ...)     SLOG_LOG(logger, siof::SLOG_LEVEL_EXCEPTION, __VA_ARGS__)
+#define SLOG_CAT_EXCEPTION(logger, category, ...)   SLOG_CAT_LOG(logger, category, siof::SLOG_LEVEL_EXCEPTION, __VA_ARGS__)
+#else
+#define SLOG_EXCEPTION(logger, ...)     SLOG_DISABLED(logger, siof::SLOG_LEVEL_EXCEPTION, __VA_ARGS__)
+#define SLOG_CAT_EXCEPTION(logger, category, ...)   SLOG_CAT_DISABLED(logger, category, siof::SLOG_LEVEL_EXCEPTION, __VA_ARGS__)
+#endif
+
+#if SLOG_MIN_LEVEL <= 7
+#define SLOG_INFO(logger, ...)          SLOG_LOG(logger, siof::SLOG_LEVEL_INFO, __VA_ARGS__)
+#define SLOG_CAT_INFO(logger, category, ...)        SLOG_CAT_LOG(logger, category, siof::SLOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define SLOG_INFO(logger, ...)          SLOG_DISABLED(logger, siof::SLOG_LEVEL_INFO, __VA_ARGS__)
+#define SLOG_CAT_INFO(logger, category, ...)        SLOG_CAT_DISABLED(logger, category, siof::SLOG_LEVEL_INFO, __VA_ARGS__)
+#endif
+
+#ifdef SLOG_HEADER_ONLY
+#include "logger.cpp"
+#endif
+
 #endif // SIOF_LOGGER
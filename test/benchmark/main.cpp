@@ -0,0 +1,425 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <logger.h>
+#include <logTime.h>
+
+// benchmark [max threads] [messages per thread] [end to end probes]
+//
+// producer: per call latency percentiles of Logger::Log / AddMessage for 1..max threads and message sizes
+// throughput: messages and bytes per second until everything is written (Close returned)
+// end to end: time from Log call until line is in file (ERROR lines are written at once)
+// allocs/msg: heap allocations (all threads, logging thread included) per message while producers run
+// wakes/msg: logging thread wake-up signals sent by producers per message (see Logger::SetWaitStrategy)
+
+#define MAX_THREADS         8
+#define MSG_PER_THREAD      100000
+#define E2E_PROBES          200
+
+typedef std::chrono::steady_clock BenchClock;
+
+std::atomic<std::uint64_t> allocations(0);
+
+// all forms are replaced, so every new/delete pair meets in malloc/free.
+// new/delete are kept out of line - GCC would pair malloc/free inlined into callers with delete/new otherwise
+#ifdef __GNUC__
+#define BENCH_NOINLINE      __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+BENCH_NOINLINE void * operator new(std::size_t size)
+{
+    ++allocations;
+
+    void * p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void * operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+BENCH_NOINLINE void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    ++allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t & tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+BENCH_NOINLINE void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void * p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void * p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void * p, const std::nothrow_t &) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void * p, const std::nothrow_t &) noexcept
+{
+    operator delete(p);
+}
+
+enum FrontEnd
+{
+    FRONT_LOG           = 0,    // Logger::Log - deferred formatting
+    FRONT_ADD_FMT       = 1,    // Logger::AddMessage(fmt, ...) - formatting on caller
+    FRONT_ADD_STR       = 2,    // Logger::AddMessage(std::string)
+    FRONT_DISABLED      = 3,    // SLOG_DEBUG below minimal log level - cost of disabled statement
+    FRONT_CAT_DISABLED  = 4,    // SLOG_CAT_DEBUG below category level
+
+    FRONT_COUNT
+};
+
+const char * frontEndNames[] = { "Log", "AddMessage(fmt)", "AddMessage(str)", "SLOG_DEBUG(off)", "SLOG_CAT(off)" };
+
+const char * waitStrategyNames[] = { "Log park", "Log spin", "Log yield", "Log batch" };
+
+enum FileMode
+{
+    FILE_WRITE          = 0,    // write(2) on logging thread
+    FILE_ASYNC          = 1,    // OPTION_FILE_ASYNC_IO
+    FILE_DIRECT         = 2,    // OPTION_FILE_ASYNC_IO + OPTION_FILE_DIRECT_IO
+    FILE_RECORDER       = 3,    // DEBUG kept by flight recorder only
+
+    FILE_MODE_COUNT
+};
+
+const char * fileModeNames[] = { "Log write", "Log io_uring", "Log O_DIRECT", "Log recorder" };
+
+struct Result
+{
+    double p50;
+    double p99;
+    double p999;
+    double max;
+    double seconds;
+    std::uint64_t msgs;
+    std::uint64_t bytes;
+    std::uint64_t allocs;
+    std::uint64_t signals;
+};
+
+std::uint64_t FileSize(const std::string & path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? std::uint64_t(st.st_size) : 0;
+}
+
+std::string LogFilePath(const std::string & name)
+{
+    char date[16];
+    std::time_t now = std::time(nullptr);
+    std::tm tmpTm;
+    siof::LocalTime(now, tmpTm);
+    std::strftime(date, sizeof(date), "_%Y_%m_%d", &tmpTm);
+
+    return name + date + ".log";
+}
+
+/// returns nanoseconds value at given percentile of sorted samples
+double Percentile(const std::vector<std::int64_t> & sorted, double percentile)
+{
+    if (sorted.empty())
+        return 0.0;
+
+    std::size_t index = std::size_t(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    return double(sorted[std::min(index, sorted.size() - 1)]);
+}
+
+Result RunProducers(int threadCount, int msgPerThread, std::size_t msgSize, FrontEnd frontEnd,
+                    siof::LogWaitStrategy waitStrategy = siof::SLOG_WAIT_PARK, FileMode fileMode = FILE_WRITE)
+{
+    std::string fileName("benchmark_run");
+    std::string filePath = LogFilePath(fileName);
+    std::remove(filePath.c_str());
+
+    std::vector<std::vector<std::int64_t> > latencies(threadCount);
+    std::vector<std::thread> threads;
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+
+    siof::Logger logger;
+    logger.SetFileName(fileName);
+    if (frontEnd == FRONT_DISABLED)
+        logger.SetMinimalLogLevel(siof::SLOG_LEVEL_WARNING);
+    if (frontEnd == FRONT_CAT_DISABLED)
+        logger.SetCategoryLevel("bench", siof::SLOG_LEVEL_WARNING);
+    siof::LogCategory & category = logger.GetCategory("bench.run");
+    logger.SetWaitStrategy(waitStrategy);
+    logger.SetOption(siof::OPTION_FILE_ASYNC_IO, fileMode == FILE_ASYNC || fileMode == FILE_DIRECT);
+    logger.SetOption(siof::OPTION_FILE_DIRECT_IO, fileMode == FILE_DIRECT);
+    if (fileMode == FILE_RECORDER)
+        logger.SetFlightRecorder(4096);
+    logger.Start();
+
+    std::uint64_t startSize = FileSize(filePath);
+
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.push_back(std::thread([&, t] () -> void
+        {
+            std::vector<std::int64_t> & samples = latencies[t];
+            samples.reserve(msgPerThread);
+
+            std::string payload(msgSize, 'x');
+
+            ++ready;
+            while (!go)
+                std::this_thread::yield();
+
+            for (int i = 0; i < msgPerThread; ++i)
+            {
+                auto start = BenchClock::now();
+
+                switch (frontEnd)
+                {
+                    case FRONT_LOG:
+                        logger.Log(siof::SLOG_LEVEL_DEBUG, "thread %d iter %d %s", t, i, payload);
+                        break;
+                    case FRONT_ADD_FMT:
+                        logger.AddMessage(siof::SLOG_LEVEL_DEBUG, "thread %d iter %d %s", t, i, payload.c_str());
+                        break;
+                    case FRONT_ADD_STR:
+                        logger.AddMessage(siof::SLOG_LEVEL_DEBUG, payload);
+                        break;
+                    case FRONT_DISABLED:
+                        SLOG_DEBUG(logger, "thread %d iter %d %s", t, i, payload);
+                        break;
+                    case FRONT_CAT_DISABLED:
+                        SLOG_CAT_DEBUG(logger, category, "thread %d iter %d %s", t, i, payload);
+                        break;
+                    default:
+                        break;
+                }
+
+                samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count());
+            }
+        }));
+    }
+
+    while (ready < threadCount)
+        std::this_thread::yield();
+
+    std::uint64_t startAllocs = allocations;
+    auto start = BenchClock::now();
+    go = true;
+
+    for (auto & thr : threads)
+        thr.join();
+
+    std::uint64_t allocs = allocations - startAllocs;
+
+    logger.Close();
+
+    std::uint64_t signals = logger.GetStats().signals;
+
+    auto end = BenchClock::now();
+
+    std::vector<std::int64_t> all;
+    all.reserve(std::size_t(threadCount) * msgPerThread);
+    for (auto & samples : latencies)
+        all.insert(all.end(), samples.begin(), samples.end());
+
+    std::sort(all.begin(), all.end());
+
+    Result result;
+    result.p50 = Percentile(all, 50.0);
+    result.p99 = Percentile(all, 99.0);
+    result.p999 = Percentile(all, 99.9);
+    result.max = all.empty() ? 0.0 : double(all.back());
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.msgs = all.size();
+    result.bytes = FileSize(filePath) - startSize;
+    result.allocs = allocs;
+    result.signals = signals;
+
+    std::remove(filePath.c_str());
+
+    return result;
+}
+
+/// measures time from Log call to line being in file while background threads keep logging
+Result RunEndToEnd(int backgroundThreads, int probes, siof::LogWaitStrategy waitStrategy = siof::SLOG_WAIT_PARK)
+{
+    std::string fileName("benchmark_e2e");
+    std::string filePath = LogFilePath(fileName);
+    std::remove(filePath.c_str());
+
+    siof::Logger logger;
+    logger.SetFileName(fileName);
+    // background lines wait in buffer, ERROR probe forces write of whole batch
+    logger.SetFlushPolicy(1024 * 1024, 1000);
+    logger.SetWaitStrategy(waitStrategy);
+    logger.Start();
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < backgroundThreads; ++t)
+    {
+        threads.push_back(std::thread([&, t] () -> void
+        {
+            for (int i = 0; !stop; ++i)
+            {
+                logger.Log(siof::SLOG_LEVEL_DEBUG, "background %d iter %d", t, i);
+
+                if (i % 64 == 0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }));
+    }
+
+    std::vector<std::int64_t> samples;
+
+    for (int i = 0; i < probes; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+        std::uint64_t size = FileSize(filePath);
+        auto start = BenchClock::now();
+
+        logger.Log(siof::SLOG_LEVEL_ERROR, "probe %d", i);
+
+        while (FileSize(filePath) == size)
+            std::this_thread::yield();
+
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count());
+    }
+
+    stop = true;
+    for (auto & thr : threads)
+        thr.join();
+
+    logger.Close();
+    std::remove(filePath.c_str());
+
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.p50 = Percentile(samples, 50.0);
+    result.p99 = Percentile(samples, 99.0);
+    result.p999 = Percentile(samples, 99.9);
+    result.max = samples.empty() ? 0.0 : double(samples.back());
+    result.seconds = 0.0;
+    result.msgs = samples.size();
+    result.bytes = 0;
+    result.allocs = 0;
+    result.signals = 0;
+
+    return result;
+}
+
+void PrintHeader()
+{
+    std::printf("%-16s %7s %6s %10s %10s %10s %10s %12s %10s %11s %10s\n",
+                "front end", "threads", "size", "p50 ns", "p99 ns", "p99.9 ns", "max ns", "msg/s", "MB/s", "allocs/msg", "wakes/msg");
+}
+
+void PrintResult(const char * name, int threadCount, std::size_t msgSize, const Result & result)
+{
+    std::printf("%-16s %7d %6u %10.0f %10.0f %10.0f %10.0f",
+                name, threadCount, unsigned(msgSize), result.p50, result.p99, result.p999, result.max);
+
+    // throughput is measured only by producer runs
+    if (result.seconds > 0.0)
+        std::printf(" %12.0f %10.2f %11.4f %10.4f\n", result.msgs / result.seconds, result.bytes / result.seconds / (1024.0 * 1024.0),
+                    double(result.allocs) / result.msgs, double(result.signals) / result.msgs);
+    else
+        std::printf(" %12s %10s %11s %10s\n", "-", "-", "-", "-");
+    std::fflush(stdout);
+}
+
+int main(int argc, char * argv[])
+{
+    int maxThreads = MAX_THREADS;
+    int msgPerThread = MSG_PER_THREAD;
+    int probes = E2E_PROBES;
+
+    if (argc > 1)
+        maxThreads = std::max(1, atoi(argv[1]));
+
+    if (argc > 2)
+        msgPerThread = std::max(1, atoi(argv[2]));
+
+    if (argc > 3)
+        probes = std::max(1, atoi(argv[3]));
+
+    const std::size_t msgSizes[] = { 16, 64, 256, 1024 };
+
+    std::printf("Producer latency and throughput (%d messages per thread)\n", msgPerThread);
+    PrintHeader();
+
+    // thread scaling for all front ends with small messages
+    for (int frontEnd = FRONT_LOG; frontEnd < FRONT_COUNT; ++frontEnd)
+        for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+            PrintResult(frontEndNames[frontEnd], threadCount, msgSizes[0],
+                        RunProducers(threadCount, msgPerThread, msgSizes[0], FrontEnd(frontEnd)));
+
+    std::printf("\nMessage size scaling (%d threads)\n", maxThreads);
+    PrintHeader();
+
+    for (std::size_t msgSize : msgSizes)
+        PrintResult(frontEndNames[FRONT_LOG], maxThreads, msgSize, RunProducers(maxThreads, msgPerThread, msgSize, FRONT_LOG));
+
+    std::printf("\nWait strategies (%d threads)\n", maxThreads);
+    PrintHeader();
+
+    for (int strategy = siof::SLOG_WAIT_PARK; strategy <= siof::SLOG_WAIT_BATCH; ++strategy)
+        PrintResult(waitStrategyNames[strategy], maxThreads, msgSizes[0],
+                    RunProducers(maxThreads, msgPerThread, msgSizes[0], FRONT_LOG, siof::LogWaitStrategy(strategy)));
+
+    for (int strategy = siof::SLOG_WAIT_PARK; strategy <= siof::SLOG_WAIT_BATCH; ++strategy)
+        PrintResult(waitStrategyNames[strategy], 1, 0, RunEndToEnd(1, probes, siof::LogWaitStrategy(strategy)));
+
+    std::printf("\nFile write modes (%d threads)\n", maxThreads);
+    PrintHeader();
+
+    for (int fileMode = FILE_WRITE; fileMode < FILE_MODE_COUNT; ++fileMode)
+        PrintResult(fileModeNames[fileMode], maxThreads, msgSizes[2],
+                    RunProducers(maxThreads, msgPerThread, msgSizes[2], FRONT_LOG, siof::SLOG_WAIT_PARK, FileMode(fileMode)));
+
+    std::printf("\nEnd to end latency (Log call -> line in file, %d probes)\n", probes);
+    PrintHeader();
+
+    for (int threadCount = 0; threadCount <= maxThreads; threadCount = threadCount ? threadCount * 2 : 1)
+        PrintResult("e2e", threadCount, 0, RunEndToEnd(threadCount, probes));
+
+    return 0;
+}
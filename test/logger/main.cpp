@@ -0,0 +1,1073 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef SLOG_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include <logger.h>
+
+// logger_test <logdecode path>
+//
+// behaviour checks of logger writing real files: rendered formats, binary file decoded by logdecode,
+// gzip file, size rolling with retention, overflow policies, collapsed repeats and flight recorder with stats,
+// logging from sink, crash handler. Every test works in own directory under logger_test_files (cleaned when
+// test starts). Exit code is count of failed checks.
+
+#define TEST_DIR            "logger_test_files"
+
+int failures = 0;
+std::string logdecodePath;
+
+#define CHECK(cond)                                                                         \
+    do                                                                                      \
+    {                                                                                       \
+        if (!(cond))                                                                        \
+        {                                                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl;  \
+            ++failures;                                                                     \
+        }                                                                                   \
+    } while (false)
+
+#define CHECK_EQUAL(a, b)                                                                   \
+    do                                                                                      \
+    {                                                                                       \
+        if (!((a) == (b)))                                                                  \
+        {                                                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #a " == " #b     \
+                      << " (" << (a) << " != " << (b) << ")" << std::endl;                  \
+            ++failures;                                                                     \
+        }                                                                                   \
+    } while (false)
+
+/// checks if Logger::Log takes given type as deferred format
+template <typename Fmt>
+struct LogAcceptsFormat
+{
+    template <typename T>
+    static char Check(decltype(std::declval<siof::Logger &>().Log(siof::SLOG_LEVEL_INFO, std::declval<T>(), 1)) *);
+    template <typename T>
+    static long Check(...);
+
+    static const bool value = sizeof(Check<Fmt>(nullptr)) == sizeof(char);
+};
+
+// only pointer of format is queued - mutable buffer could change or go out of scope before logging thread reads it
+static_assert(LogAcceptsFormat<const char (&)[8]>::value, "string literal is format");
+static_assert(!LogAcceptsFormat<char (&)[8]>::value, "mutable buffer is not format");
+
+/// returns sorted names of files in dir
+std::vector<std::string> ListFiles(const std::string & dir)
+{
+    std::vector<std::string> names;
+
+    DIR * d = opendir(dir.c_str());
+    if (!d)
+        return names;
+
+    while (struct dirent * entry = readdir(d))
+    {
+        if (entry->d_name[0] != '.')
+            names.push_back(entry->d_name);
+    }
+
+    closedir(d);
+
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+/// creates empty directory for test, returns "<dir>/log" (file name passed to logger)
+std::string PrepareDir(const std::string & name)
+{
+    mkdir(TEST_DIR, 0755);
+
+    std::string dir = TEST_DIR "/" + name;
+    mkdir(dir.c_str(), 0755);
+
+    for (const std::string & file : ListFiles(dir))
+        std::remove((dir + "/" + file).c_str());
+
+    return dir + "/log";
+}
+
+/// returns path of only log file in dir of given logger file name
+std::string GetLogFile(const std::string & fileName)
+{
+    std::string dir = fileName.substr(0, fileName.rfind('/'));
+    std::vector<std::string> files = ListFiles(dir);
+
+    CHECK_EQUAL(files.size(), 1u);
+    return files.empty() ? std::string() : dir + "/" + files[0];
+}
+
+std::string ReadFile(const std::string & path)
+{
+    std::ifstream file(path.c_str(), std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/// splits text into lines without separator lines ("####...") and empty ones
+std::vector<std::string> SplitLines(const std::string & text)
+{
+    std::vector<std::string> lines;
+    std::size_t pos = 0;
+
+    while (pos < text.size())
+    {
+        std::size_t end = text.find('\n', pos);
+        if (end == std::string::npos)
+            end = text.size();
+
+        std::string line = text.substr(pos, end - pos);
+        if (!line.empty() && line[0] != '#')
+            lines.push_back(line);
+
+        pos = end + 1;
+    }
+
+    return lines;
+}
+
+/// returns text line without "YYYY-MM-DD HH:MM:SS.mmm " prefix
+std::string SkipTime(const std::string & line)
+{
+    CHECK(line.size() > SLOG_TIME_SIZE && line[4] == '-' && line[10] == ' ' && line[19] == '.' && line[SLOG_TIME_SIZE] == ' ');
+    return line.size() > SLOG_TIME_SIZE ? line.substr(SLOG_TIME_SIZE + 1) : line;
+}
+
+/// logs messages used by format tests
+void LogSample(siof::Logger & logger)
+{
+    siof::LogCategory & net = logger.GetCategory("net");
+
+    logger.Log(siof::SLOG_LEVEL_INFO, "plain %d", 1);
+    logger.Log(siof::SLOG_LEVEL_WARNING, "user %s logged in", std::string("bob"), siof::kv("id", 42), siof::kv("ok", true));
+    logger.Log(net, siof::SLOG_LEVEL_ERROR, "quote \" and\nnew line", siof::kv("path", std::string("a b")), siof::kv("k=v x", 7));
+    logger.AddMessage(siof::SLOG_LEVEL_DEBUG, std::string("ready text"));
+}
+
+/// writes sample in given format, returns lines of log file
+std::vector<std::string> WriteSample(const std::string & name, siof::LogFormat format)
+{
+    std::string fileName = PrepareDir(name);
+
+    {
+        siof::Logger logger;
+        logger.SetOutputFormat(format);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        LogSample(logger);
+    }
+
+    return SplitLines(ReadFile(GetLogFile(fileName)));
+}
+
+void TestTextFormat()
+{
+    std::vector<std::string> lines = WriteSample("text", siof::SLOG_FORMAT_TEXT);
+
+    CHECK_EQUAL(lines.size(), 5u);
+    if (lines.size() != 5)
+        return;
+
+    CHECK_EQUAL(SkipTime(lines[0]), "[INFO] plain 1");
+    CHECK_EQUAL(SkipTime(lines[1]), "[WARNING] user bob logged in id=42 ok=true");
+    CHECK_EQUAL(SkipTime(lines[2]), "[ERROR] [net] quote \" and");
+    CHECK_EQUAL(lines[3], "new line path=\"a b\" k_v_x=7");
+    CHECK_EQUAL(SkipTime(lines[4]), "[DEBUG] ready text");
+}
+
+void TestLogfmtFormat()
+{
+    std::vector<std::string> lines = WriteSample("logfmt", siof::SLOG_FORMAT_LOGFMT);
+
+    CHECK_EQUAL(lines.size(), 4u);
+    if (lines.size() != 4)
+        return;
+
+    // ts=YYYY-MM-DDTHH:MM:SS.mmm+hh:mm
+    for (const std::string & line : lines)
+        CHECK(line.compare(0, 3, "ts=") == 0 && line[13] == 'T' && line.size() > 32 && line[32] == ' ');
+
+    CHECK_EQUAL(lines[0].substr(33), "level=INFO msg=\"plain 1\"");
+    CHECK_EQUAL(lines[1].substr(33), "level=WARNING msg=\"user bob logged in\" id=42 ok=true");
+    CHECK_EQUAL(lines[2].substr(33), "level=ERROR category=net msg=\"quote \\\" and\\nnew line\" path=\"a b\" k_v_x=7");
+    CHECK_EQUAL(lines[3].substr(33), "level=DEBUG msg=\"ready text\"");
+}
+
+void TestJsonFormat()
+{
+    std::vector<std::string> lines = WriteSample("json", siof::SLOG_FORMAT_JSON);
+
+    CHECK_EQUAL(lines.size(), 4u);
+    if (lines.size() != 4)
+        return;
+
+    // {"ts":"YYYY-MM-DDTHH:MM:SS.mmm+hh:mm",
+    for (const std::string & line : lines)
+        CHECK(line.compare(0, 7, "{\"ts\":\"") == 0 && line.size() > 37 && line.compare(36, 2, "\",") == 0);
+
+    CHECK_EQUAL(lines[0].substr(38), "\"level\":\"INFO\",\"msg\":\"plain 1\"}");
+    CHECK_EQUAL(lines[1].substr(38), "\"level\":\"WARNING\",\"msg\":\"user bob logged in\",\"id\":42,\"ok\":true}");
+    CHECK_EQUAL(lines[2].substr(38), "\"level\":\"ERROR\",\"category\":\"net\",\"msg\":\"quote \\\" and\\nnew line\",\"path\":\"a b\",\"k=v x\":7}");
+    CHECK_EQUAL(lines[3].substr(38), "\"level\":\"DEBUG\",\"msg\":\"ready text\"}");
+}
+
+/// returns stdout of command
+std::string RunCommand(const std::string & command, int & status)
+{
+    std::string out;
+    status = -1;
+
+    FILE * pipe = popen(command.c_str(), "r");
+    if (!pipe)
+        return out;
+
+    char buffer[4096];
+    std::size_t size;
+    while ((size = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+        out.append(buffer, size);
+
+    status = pclose(pipe);
+    return out;
+}
+
+void TestBinaryRoundTrip()
+{
+    std::string fileName = PrepareDir("binary");
+
+    {
+        siof::Logger logger;
+        logger.SetOption(siof::OPTION_FILE_BINARY, true);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        LogSample(logger);
+    }
+
+    std::string path = GetLogFile(fileName);
+    CHECK(ReadFile(path).compare(1, SLOG_BINARY_MAGIC_SIZE, SLOG_BINARY_MAGIC) == 0);
+
+    int status;
+    std::vector<std::string> text = SplitLines(RunCommand(logdecodePath + " " + path, status));
+    CHECK_EQUAL(status, 0);
+
+    CHECK_EQUAL(text.size(), 5u);
+    if (text.size() == 5)
+    {
+        CHECK_EQUAL(SkipTime(text[0]), "[INFO] plain 1");
+        CHECK_EQUAL(SkipTime(text[1]), "[WARNING] user bob logged in id=42 ok=true");
+        CHECK_EQUAL(SkipTime(text[2]), "[ERROR] [net] quote \" and");
+        CHECK_EQUAL(text[3], "new line path=\"a b\" k_v_x=7");
+        CHECK_EQUAL(SkipTime(text[4]), "[DEBUG] ready text");
+    }
+
+    std::vector<std::string> json = SplitLines(RunCommand(logdecodePath + " --format json " + path, status));
+    CHECK_EQUAL(status, 0);
+    CHECK_EQUAL(json.size(), 4u);
+    if (json.size() == 4)
+        CHECK_EQUAL(json[1].substr(38), "\"level\":\"WARNING\",\"msg\":\"user bob logged in\",\"id\":42,\"ok\":true}");
+}
+
+/// decoded binary file has to match lines rendered for sink from the same messages (timestamps included)
+void TestBinaryMatchesText()
+{
+    std::string fileName = PrepareDir("binary_text");
+    std::vector<std::string> sinkLines;
+
+    {
+        siof::Logger logger;
+        logger.SetOption(siof::OPTION_FILE_BINARY, true);
+        logger.SetFileName(fileName);
+
+        std::shared_ptr<siof::LogMemorySink> sink = std::make_shared<siof::LogMemorySink>(10000);
+        logger.AddSink(sink);
+        logger.Start();
+
+        siof::LogCategory & db = logger.GetCategory("db.query");
+        int value = 0;
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            logger.Log(siof::LogLevel(1 + i % 7), "int %d uint %u neg %lld", i, unsigned(i * 7), -1234567890123LL * i);
+            logger.Log(db, siof::SLOG_LEVEL_WARNING, "double %f str %s", i / 3.0, std::string(i % 50, 'x'),
+                       siof::kv("ptr", &value), siof::kv("ok", i % 2 == 0), siof::kv("text", std::string("a \"b\"\n")));
+            logger.AddMessage(siof::SLOG_LEVEL_INFO, "ready " + std::to_string(i));
+        }
+
+        logger.Close();
+        sink->GetLines(sinkLines);
+    }
+
+    std::ifstream file(GetLogFile(fileName).c_str(), std::ios_base::binary);
+    std::ostringstream decoded;
+
+    siof::LogBinaryDecoder decoder;
+    CHECK(decoder.Decode(file, decoded));
+
+    std::string expected;
+    for (const std::string & line : sinkLines)
+        expected += line + "\n";
+
+    CHECK_EQUAL(sinkLines.size(), 3000u);
+    CHECK(SplitLines(decoded.str()) == SplitLines(expected));
+}
+
+/// returns if decoding of data fails cleanly (false result, no exception)
+bool DecodeFails(const std::string & data)
+{
+    std::istringstream in(data);
+    std::ostringstream out;
+
+    try
+    {
+        siof::LogBinaryDecoder decoder;
+        return !decoder.Decode(in, out);
+    }
+    catch (std::exception & e)
+    {
+        std::cerr << "decoder thrown " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void TestBinaryCorrupted()
+{
+    std::string fileName = PrepareDir("binary_corrupted");
+
+    {
+        siof::Logger logger;
+        logger.SetOption(siof::OPTION_FILE_BINARY, true);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        LogSample(logger);
+    }
+
+    std::string data = ReadFile(GetLogFile(fileName));
+    CHECK(!DecodeFails(data));
+
+    // session record with empty separator
+    std::string session = data.substr(0, data.find(SLOG_BINARY_MAGIC) + SLOG_BINARY_MAGIC_SIZE);
+    session += '\0';
+    session += '\0';
+    session += SLOG_BINARY_RECORD_END;
+
+    // huge string size
+    std::string huge = session;
+    huge += char(siof::SLOG_BIN_FORMAT);
+    huge += '\x01';
+    huge += std::string(8, '\xff') + '\x3f';
+    huge += "%s";
+    CHECK(DecodeFails(huge));
+
+    // huge format id
+    std::string id = session;
+    id += char(siof::SLOG_BIN_FORMAT);
+    id += std::string(5, '\xff') + '\x0f';
+    id += '\x02';
+    id += "%s";
+    id += SLOG_BINARY_RECORD_END;
+    CHECK(DecodeFails(id));
+
+    // huge packed string arg
+    std::string arg = session;
+    arg += char(siof::SLOG_BIN_MSG);
+    arg += '\0';
+    arg += char(siof::SLOG_LEVEL_INFO);
+    arg += '\0';
+    arg += '\x0b';
+    arg += char(siof::SLOG_ARG_STRING);
+    arg += std::string(9, '\xff') + '\x01';
+    CHECK(DecodeFails(arg));
+
+    // every truncation and every damaged byte ends decoding without exception
+    for (std::size_t size = 0; size < data.size(); ++size)
+        DecodeFails(data.substr(0, size));
+
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        std::string damaged = data;
+        damaged[i] = char(damaged[i] ^ 0xA5);
+        DecodeFails(damaged);
+    }
+}
+
+void TestCompression()
+{
+    if (!siof::LogFileSink::CanCompress())
+    {
+        std::cout << "compression: skipped (built without zlib)" << std::endl;
+        return;
+    }
+
+#ifdef SLOG_WITH_ZLIB
+    std::string fileName = PrepareDir("gzip");
+
+    {
+        siof::Logger logger;
+        logger.SetOption(siof::OPTION_FILE_COMPRESSION, true);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        for (int i = 0; i < 1000; ++i)
+            logger.Log(siof::SLOG_LEVEL_INFO, "compressed line %d", i);
+    }
+
+    std::string path = GetLogFile(fileName);
+    CHECK(path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0);
+
+    std::string raw = ReadFile(path);
+    CHECK(raw.size() > 2 && raw[0] == '\x1f' && raw[1] == '\x8b');
+
+    std::string text;
+    gzFile file = gzopen(path.c_str(), "rb");
+    CHECK(file != nullptr);
+
+    if (file)
+    {
+        char buffer[4096];
+        int size;
+        while ((size = gzread(file, buffer, sizeof(buffer))) > 0)
+            text.append(buffer, size);
+
+        gzclose(file);
+    }
+
+    std::vector<std::string> lines = SplitLines(text);
+    CHECK_EQUAL(lines.size(), 1000u);
+    if (lines.size() == 1000)
+    {
+        CHECK_EQUAL(SkipTime(lines[0]), "[INFO] compressed line 0");
+        CHECK_EQUAL(SkipTime(lines[999]), "[INFO] compressed line 999");
+    }
+
+    CHECK(raw.size() < text.size() / 4);
+#endif
+}
+
+void TestRollingRetention()
+{
+    const std::uint64_t maxBytes = 4096;
+    const std::size_t maxFiles = 3;
+
+    std::string fileName = PrepareDir("rolling");
+    std::string dir = fileName.substr(0, fileName.rfind('/'));
+
+    {
+        siof::Logger logger;
+        logger.SetRollingPolicy(maxBytes, 0);
+        logger.SetRetention(maxFiles, 0);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        // ~64 bytes per line - about 30 parts
+        for (int i = 0; i < 2000; ++i)
+        {
+            logger.Log(siof::SLOG_LEVEL_INFO, "rolling line %05d padding padding", i);
+
+            // parts are started between batches - small batches keep parts close to limit
+            if (i % 20 == 19)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::vector<std::string> files = ListFiles(dir);
+    CHECK_EQUAL(files.size(), maxFiles);
+
+    // newest parts are kept (<name>_YYYY_MM_DD_N.log), last one holds last line
+    std::vector<std::string> lines;
+    int lastPart = 0;
+
+    for (const std::string & file : files)
+    {
+        std::string path = dir + "/" + file;
+        std::string text = ReadFile(path);
+
+        // part is closed once it reaches limit - with lines of at most one batch over it
+        CHECK(text.size() < maxBytes + SLOG_BATCH_SIZE * 64);
+
+        // log_YYYY_MM_DD[_N].log
+        if (file.size() > 15 && file[14] == '_')
+            lastPart = std::max(lastPart, std::atoi(file.c_str() + 15));
+
+        std::vector<std::string> fileLines = SplitLines(text);
+        lines.insert(lines.end(), fileLines.begin(), fileLines.end());
+    }
+
+    CHECK(lastPart >= 10);
+
+    std::sort(lines.begin(), lines.end(), [] (const std::string & a, const std::string & b) -> bool
+                { return SkipTime(a) < SkipTime(b); });
+
+    CHECK(!lines.empty());
+    if (!lines.empty())
+        CHECK_EQUAL(SkipTime(lines.back()), "[INFO] rolling line 01999 padding padding");
+}
+
+void TestRetentionSiblings()
+{
+    std::string fileName = PrepareDir("retention_siblings");
+    std::string dir = fileName.substr(0, fileName.rfind('/'));
+
+    // own old files with index, files of logger "log_2" and other files with similar names
+    const char * existing[] = { "log_2020_01_01.log", "log_2020_01_01.log.idx", "log_2020_01_02_1.log.gz",
+                                "log_2_2020_01_01.log", "log_2_2020_01_01.log.idx", "log_1.conf", "log_2020_01_01.txt" };
+
+    for (const char * name : existing)
+        std::ofstream((dir + "/" + name).c_str()) << name << "\n";
+
+    {
+        siof::Logger logger;
+        logger.SetRetention(2, 0);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        logger.Log(siof::SLOG_LEVEL_INFO, "line");
+    }
+
+    // only oldest own file (and its index) is removed
+    std::vector<std::string> files = ListFiles(dir);
+    CHECK_EQUAL(files.size(), 6u);
+    CHECK(std::find(files.begin(), files.end(), "log_2020_01_01.log") == files.end());
+    CHECK(std::find(files.begin(), files.end(), "log_2020_01_01.log.idx") == files.end());
+
+    for (std::size_t i = 2; i < sizeof(existing) / sizeof(existing[0]); ++i)
+        CHECK(std::find(files.begin(), files.end(), existing[i]) != files.end());
+}
+
+void TestIndexPartialWrite()
+{
+    const std::size_t maxSize = 10000;
+
+    std::string fileName = PrepareDir("index_partial");
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        // file can't grow over limit - write is cut short and then fails (EFBIG)
+        struct rlimit limit;
+        limit.rlim_cur = limit.rlim_max = maxSize;
+        signal(SIGXFSZ, SIG_IGN);
+        if (setrlimit(RLIMIT_FSIZE, &limit) != 0)
+            _exit(2);
+
+        siof::Logger logger;
+        logger.SetOption(siof::OPTION_FILE_INDEX, true);
+        logger.SetFlushPolicy(0, 0);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        for (int i = 0; i < 500; ++i)
+        {
+            logger.Log(siof::SLOG_LEVEL_INFO, "indexed line %05d padding padding", i);
+
+            if (i % 10 == 9)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        logger.Close();
+        _exit(0);
+    }
+
+    int status = 0;
+    CHECK(pid > 0 && waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    std::string dir = fileName.substr(0, fileName.rfind('/'));
+    std::string path;
+    for (const std::string & file : ListFiles(dir))
+    {
+        if (file.size() > 4 && file.compare(file.size() - 4, 4, ".log") == 0)
+            path = dir + "/" + file;
+    }
+
+    std::string text = ReadFile(path);
+    CHECK_EQUAL(text.size(), maxSize);
+
+    // index describes only whole lines which are in file
+    std::vector<siof::LogIndexRecord> records;
+    CHECK(siof::LogIndexWriter::Read(path + SLOG_INDEX_EXTENSION, records));
+    CHECK(!records.empty());
+
+    for (const siof::LogIndexRecord & record : records)
+    {
+        CHECK(record.offset + record.size <= text.size());
+        if (record.size && record.offset + record.size <= text.size())
+            CHECK_EQUAL(text[record.offset + record.size - 1], '\n');
+    }
+}
+
+/// logging thread is stopped in sink until Release - queue of given capacity fills up
+class StalledWriter
+{
+public:
+    StalledWriter() : entered_(false), released_(false) {}
+
+    std::shared_ptr<siof::LogSink> CreateSink()
+    {
+        return std::make_shared<siof::LogCallbackSink>([this] (siof::LogLevel, const char *, std::size_t) -> void
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+
+                    entered_ = true;
+                    cond_.notify_all();
+                    cond_.wait(lock, [this] () -> bool { return released_; });
+                });
+    }
+
+    void WaitEntered()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] () -> bool { return entered_; });
+    }
+
+    void Release()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        released_ = true;
+        cond_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool entered_;
+    bool released_;
+};
+
+struct OverflowResult
+{
+    std::vector<std::string> lines;
+    std::uint64_t dropped;
+    std::uint64_t droppedDebug;
+};
+
+/// first message stops logging thread, count messages are logged into queue of 16 slots
+/// while it's stopped, then urgent message is logged from other thread (it may wait)
+OverflowResult RunOverflow(const std::string & name, siof::LogOverflowPolicy policy, int count, siof::LogLevel level)
+{
+    std::string fileName = PrepareDir(name);
+    OverflowResult result;
+
+    {
+        StalledWriter stalled;
+
+        siof::Logger logger;
+        logger.SetQueueCapacity(16);
+        logger.SetOverflowPolicy(policy, siof::SLOG_LEVEL_WARNING);
+        logger.SetFileName(fileName);
+        logger.AddSink(stalled.CreateSink());
+        logger.Start();
+
+        logger.Log(siof::SLOG_LEVEL_INFO, "first");
+        stalled.WaitEntered();
+
+        std::atomic<int> logged(0);
+        std::thread producer([&] () -> void
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    logger.Log(level, "msg %d", i);
+                    ++logged;
+                }
+
+                logger.Log(siof::SLOG_LEVEL_ERROR, "urgent");
+                ++logged;
+            });
+
+        // dropping policies never wait - blocking one (and urgent message with below level one) waits for free slot
+        if (policy == siof::SLOG_OVERFLOW_DROP_NEWEST || policy == siof::SLOG_OVERFLOW_DROP_OLDEST)
+        {
+            while (logged < count + 1)
+                std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            CHECK_EQUAL(logged.load(), policy == siof::SLOG_OVERFLOW_BLOCK ? 16 : count);
+        }
+
+        stalled.Release();
+        producer.join();
+        logger.Close();
+
+        result.dropped = logger.GetDroppedCount();
+        siof::LogStats stats = logger.GetStats();
+        result.droppedDebug = stats.dropped[siof::SLOG_LEVEL_DEBUG];
+
+        // every logged message (first, count, urgent) is either written or dropped, "N messages dropped" line is neither
+        CHECK_EQUAL(stats.GetWritten() + stats.GetDropped(), std::uint64_t(count + 2));
+    }
+
+    for (const std::string & line : SplitLines(ReadFile(GetLogFile(fileName))))
+        result.lines.push_back(SkipTime(line));
+
+    return result;
+}
+
+void TestOverflowPolicies()
+{
+    // newest: 16 queued messages are kept, others and urgent one are dropped
+    OverflowResult newest = RunOverflow("overflow_newest", siof::SLOG_OVERFLOW_DROP_NEWEST, 100, siof::SLOG_LEVEL_INFO);
+
+    CHECK_EQUAL(newest.dropped, 85u);
+    CHECK_EQUAL(newest.lines.size(), 18u);
+    if (newest.lines.size() == 18)
+    {
+        CHECK_EQUAL(newest.lines[0], "[INFO] first");
+        CHECK_EQUAL(newest.lines[1], "[INFO] msg 0");
+        CHECK_EQUAL(newest.lines[16], "[INFO] msg 15");
+        CHECK_EQUAL(newest.lines[17], "[WARNING] 85 messages dropped (log queue full)");
+    }
+
+    // oldest: last 16 messages (urgent one included) are kept
+    OverflowResult oldest = RunOverflow("overflow_oldest", siof::SLOG_OVERFLOW_DROP_OLDEST, 100, siof::SLOG_LEVEL_INFO);
+
+    CHECK_EQUAL(oldest.dropped, 85u);
+    CHECK_EQUAL(oldest.lines.size(), 18u);
+    if (oldest.lines.size() == 18)
+    {
+        CHECK_EQUAL(oldest.lines[1], "[INFO] msg 85");
+        CHECK_EQUAL(oldest.lines[15], "[INFO] msg 99");
+        CHECK_EQUAL(oldest.lines[16], "[ERROR] urgent");
+        CHECK_EQUAL(oldest.lines[17], "[WARNING] 85 messages dropped (log queue full)");
+    }
+
+    // below level: DEBUG messages over capacity are dropped, ERROR waits for slot
+    OverflowResult below = RunOverflow("overflow_below", siof::SLOG_OVERFLOW_DROP_BELOW_LEVEL, 100, siof::SLOG_LEVEL_DEBUG);
+
+    CHECK_EQUAL(below.dropped, 84u);
+    CHECK_EQUAL(below.droppedDebug, 84u);
+    CHECK_EQUAL(below.lines.size(), 19u);
+    if (below.lines.size() == 19)
+    {
+        CHECK_EQUAL(below.lines[16], "[DEBUG] msg 15");
+        CHECK(std::find(below.lines.begin(), below.lines.end(), "[ERROR] urgent") != below.lines.end());
+        CHECK(std::find(below.lines.begin(), below.lines.end(), "[WARNING] 84 messages dropped (log queue full)") != below.lines.end());
+    }
+
+    // block: nothing is lost
+    OverflowResult block = RunOverflow("overflow_block", siof::SLOG_OVERFLOW_BLOCK, 100, siof::SLOG_LEVEL_INFO);
+
+    CHECK_EQUAL(block.dropped, 0u);
+    CHECK_EQUAL(block.lines.size(), 102u);
+    if (block.lines.size() == 102)
+    {
+        CHECK_EQUAL(block.lines[100], "[INFO] msg 99");
+        CHECK_EQUAL(block.lines[101], "[ERROR] urgent");
+    }
+}
+
+void TestCollapseRepeats()
+{
+    std::string fileName = PrepareDir("collapse");
+    siof::LogStats stats;
+
+    {
+        siof::Logger logger;
+        logger.SetOption(siof::OPTION_COLLAPSE_REPEATS, true);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        for (int i = 0; i < 5; ++i)
+            logger.Log(siof::SLOG_LEVEL_INFO, "same %d", 1);
+
+        logger.Log(siof::SLOG_LEVEL_INFO, "other");
+        logger.Close();
+
+        stats = logger.GetStats();
+    }
+
+    std::vector<std::string> lines;
+    for (const std::string & line : SplitLines(ReadFile(GetLogFile(fileName))))
+        lines.push_back(SkipTime(line));
+
+    CHECK_EQUAL(lines.size(), 3u);
+    if (lines.size() == 3)
+    {
+        CHECK_EQUAL(lines[0], "[INFO] same 1");
+        CHECK_EQUAL(lines[1], "[INFO] previous message repeated 4 times");
+        CHECK_EQUAL(lines[2], "[INFO] other");
+    }
+
+    // collapsed messages are counted only as repeats
+    CHECK_EQUAL(stats.enqueued, 6u);
+    CHECK_EQUAL(stats.repeats, 4u);
+    CHECK_EQUAL(stats.written[siof::SLOG_LEVEL_INFO], 2u);
+    CHECK_EQUAL(stats.repeats + stats.GetWritten(), stats.enqueued);
+}
+
+void TestFlightRecorder()
+{
+    std::string fileName = PrepareDir("recorder");
+    siof::LogStats stats;
+
+    {
+        siof::Logger logger;
+        logger.SetFlightRecorder(4);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        logger.Log(siof::SLOG_LEVEL_INFO, "start");
+
+        for (int i = 0; i < 10; ++i)
+            logger.Log(siof::SLOG_LEVEL_DEBUG, "keep %d", i);
+
+        logger.Log(siof::SLOG_LEVEL_ERROR, "failed");
+
+        for (int i = 10; i < 13; ++i)
+            logger.Log(siof::SLOG_LEVEL_DEBUG, "keep %d", i);
+
+        logger.Log(siof::SLOG_LEVEL_INFO, "end");
+        logger.Close();
+
+        stats = logger.GetStats();
+    }
+
+    std::vector<std::string> lines;
+    for (const std::string & line : SplitLines(ReadFile(GetLogFile(fileName))))
+        lines.push_back(SkipTime(line));
+
+    // last 4 kept messages are written before trigger level, later ones stay in memory
+    CHECK_EQUAL(lines.size(), 7u);
+    if (lines.size() == 7)
+    {
+        CHECK_EQUAL(lines[0], "[INFO] start");
+        CHECK_EQUAL(lines[1], "[DEBUG] keep 6");
+        CHECK_EQUAL(lines[4], "[DEBUG] keep 9");
+        CHECK_EQUAL(lines[5], "[ERROR] failed");
+        CHECK_EQUAL(lines[6], "[INFO] end");
+    }
+
+    // kept messages are counted only as recorded (also the written ones)
+    CHECK_EQUAL(stats.enqueued, 16u);
+    CHECK_EQUAL(stats.recorded, 13u);
+    CHECK_EQUAL(stats.recorderDumps, 1u);
+    CHECK_EQUAL(stats.written[siof::SLOG_LEVEL_DEBUG], 0u);
+    CHECK_EQUAL(stats.recorded + stats.GetWritten(), stats.enqueued);
+}
+
+void TestLogFromSink()
+{
+    std::string fileName = PrepareDir("from_sink");
+
+    {
+        siof::Logger logger;
+        bool logged = false;
+
+        // callback runs on logging thread - sync level message must not wait for it
+        logger.AddSink(std::make_shared<siof::LogCallbackSink>([&] (siof::LogLevel, const char *, std::size_t) -> void
+                {
+                    if (logged)
+                        return;
+
+                    logged = true;
+                    logger.Log(siof::SLOG_LEVEL_FATAL, "from sink");
+                }));
+
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        logger.Log(siof::SLOG_LEVEL_INFO, "first");
+        logger.Close();
+    }
+
+    std::vector<std::string> lines;
+    for (const std::string & line : SplitLines(ReadFile(GetLogFile(fileName))))
+        lines.push_back(SkipTime(line));
+
+    CHECK_EQUAL(lines.size(), 2u);
+    if (lines.size() == 2)
+    {
+        CHECK_EQUAL(lines[0], "[INFO] first");
+        CHECK_EQUAL(lines[1], "[FATAL] from sink");
+    }
+}
+
+void TestBlockFromSink()
+{
+    std::string fileName = PrepareDir("block_from_sink");
+    std::uint64_t dropped = 0;
+
+    {
+        siof::Logger logger;
+        bool logged = false;
+
+        // logging thread can't wait for slot it would free itself - messages over capacity are dropped
+        logger.AddSink(std::make_shared<siof::LogCallbackSink>([&] (siof::LogLevel, const char *, std::size_t) -> void
+                {
+                    if (logged)
+                        return;
+
+                    logged = true;
+                    for (int i = 0; i < 100; ++i)
+                        logger.Log(siof::SLOG_LEVEL_INFO, "msg %d", i);
+                }));
+
+        logger.SetQueueCapacity(16);
+        logger.SetOverflowPolicy(siof::SLOG_OVERFLOW_BLOCK);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        logger.Log(siof::SLOG_LEVEL_INFO, "first");
+        logger.Close();
+
+        dropped = logger.GetDroppedCount();
+    }
+
+    std::vector<std::string> lines;
+    for (const std::string & line : SplitLines(ReadFile(GetLogFile(fileName))))
+        lines.push_back(SkipTime(line));
+
+    CHECK_EQUAL(dropped, 84u);
+    CHECK_EQUAL(lines.size(), 18u);
+    if (lines.size() == 18)
+    {
+        CHECK_EQUAL(lines[16], "[INFO] msg 15");
+        CHECK_EQUAL(lines[17], "[WARNING] 84 messages dropped (log queue full)");
+    }
+}
+
+void TestIdleWakeups()
+{
+    std::string fileName = PrepareDir("idle");
+
+    siof::Logger logger;
+    logger.SetFlushPolicy(1024 * 1024, 50);
+    logger.SetFileName(fileName);
+    logger.Start();
+
+    logger.Log(siof::SLOG_LEVEL_INFO, "line");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // parked thread wakes up for message and once for its flush, then sleeps until next message
+    siof::LogStats stats = logger.GetStats();
+    CHECK(stats.wakeups + stats.idleTimeouts <= 4);
+    CHECK_EQUAL(SplitLines(ReadFile(GetLogFile(fileName))).size(), 1u);
+
+    logger.Close();
+}
+
+void TestCrashHandler()
+{
+    std::string fileName = PrepareDir("crash");
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        // batching thread sleeps through whole test - messages are still queued at crash
+        siof::Logger logger;
+        logger.SetOption(siof::OPTION_THREAD_BUFFERS, true);
+        logger.SetWaitStrategy(siof::SLOG_WAIT_BATCH, 60000);
+        logger.SetFileName(fileName);
+        logger.Start();
+
+        if (!logger.EnableCrashHandler(true))
+            _exit(2);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        for (int i = 0; i < 3; ++i)
+            logger.Log(siof::SLOG_LEVEL_INFO, "main %d", i);
+
+        std::thread worker([&logger] ()
+        {
+            for (int i = 0; i < 3; ++i)
+                logger.Log(siof::SLOG_LEVEL_INFO, "worker %d", i);
+        });
+        worker.join();
+
+        abort();
+    }
+
+    int status = 0;
+    CHECK(pid > 0 && waitpid(pid, &status, 0) == pid);
+    CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+
+    std::vector<std::string> lines;
+    for (const std::string & line : SplitLines(ReadFile(GetLogFile(fileName))))
+        lines.push_back(SkipTime(line));
+
+    // queues of both threads, in order of registration
+    CHECK_EQUAL(lines.size(), 6u);
+    if (lines.size() == 6)
+    {
+        CHECK_EQUAL(lines[0], "[INFO] main 0");
+        CHECK_EQUAL(lines[2], "[INFO] main 2");
+        CHECK_EQUAL(lines[3], "[INFO] worker 0");
+        CHECK_EQUAL(lines[5], "[INFO] worker 2");
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: logger_test <logdecode path>" << std::endl;
+        return 1;
+    }
+
+    logdecodePath = argv[1];
+
+    struct Test
+    {
+        const char * name;
+        void (*run)();
+    };
+
+    const Test tests[] =
+    {
+        { "text format", TestTextFormat },
+        { "logfmt format", TestLogfmtFormat },
+        { "json format", TestJsonFormat },
+        { "binary round trip", TestBinaryRoundTrip },
+        { "binary matches text", TestBinaryMatchesText },
+        { "binary corrupted", TestBinaryCorrupted },
+        { "compression", TestCompression },
+        { "rolling retention", TestRollingRetention },
+        { "retention of siblings", TestRetentionSiblings },
+        { "index after partial write", TestIndexPartialWrite },
+        { "overflow policies", TestOverflowPolicies },
+        { "collapse repeats", TestCollapseRepeats },
+        { "flight recorder", TestFlightRecorder },
+        { "log from sink", TestLogFromSink },
+        { "block from sink", TestBlockFromSink },
+        { "idle wakeups", TestIdleWakeups },
+        { "crash handler", TestCrashHandler },
+    };
+
+    for (const Test & test : tests)
+    {
+        int before = failures;
+        test.run();
+
+        std::cout << test.name << ": " << (failures == before ? "ok" : "FAILED") << std::endl;
+    }
+
+    return failures;
+}
@@ -0,0 +1,63 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <logBinary.h>
+
+// logdecode - turns binary log files (OPTION_FILE_BINARY) back into text
+// usage: logdecode [--format text|logfmt|json] file [file...]   (reads stdin when no file is given)
+
+int main(int argc, char * argv[])
+{
+    std::ios_base::sync_with_stdio(false);
+
+    siof::LogBinaryDecoder decoder;
+    siof::LogFormat format = siof::SLOG_FORMAT_TEXT;
+    int result = 0;
+    int first = 1;
+
+    if (argc > 2 && std::strcmp(argv[1], "--format") == 0)
+    {
+        if (std::strcmp(argv[2], "json") == 0)
+            format = siof::SLOG_FORMAT_JSON;
+        else if (std::strcmp(argv[2], "logfmt") == 0)
+            format = siof::SLOG_FORMAT_LOGFMT;
+        else if (std::strcmp(argv[2], "text") != 0)
+        {
+            std::cerr << "logdecode: unknown format " << argv[2] << std::endl;
+            return 1;
+        }
+
+        first = 3;
+    }
+
+    if (argc <= first)
+    {
+        if (!decoder.Decode(std::cin, std::cout, format))
+        {
+            std::cerr << "logdecode: corrupted input" << std::endl;
+            result = 1;
+        }
+
+        return result;
+    }
+
+    for (int i = first; i < argc; ++i)
+    {
+        std::ifstream file(argv[i], std::ios_base::binary);
+        if (!file.is_open())
+        {
+            std::cerr << "logdecode: can't open " << argv[i] << std::endl;
+            result = 1;
+            continue;
+        }
+
+        if (!decoder.Decode(file, std::cout, format))
+        {
+            std::cerr << "logdecode: corrupted data in " << argv[i] << std::endl;
+            result = 1;
+        }
+    }
+
+    return result;
+}
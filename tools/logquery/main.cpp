@@ -0,0 +1,443 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <logIndex.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// logquery - prints lines of text log files (any output format) from time window, files are merged by time.
+// Sidecar index (OPTION_FILE_INDEX) limits reading to parts of file which can contain the window.
+// usage: logquery [--from TIME] [--to TIME] [--level LEVEL[,LEVEL...]] file [file...]
+// TIME is local "YYYY-MM-DD[ HH[:MM[:SS[.mmm]]]]", --from is inclusive, --to exclusive
+
+namespace
+{
+    /// whole file mapped for reading (read into memory where mapping is not available)
+    class MappedFile
+    {
+    public:
+        MappedFile() : data_(nullptr), size_(0) {}
+
+        ~MappedFile()
+        {
+#ifndef _WIN32
+            if (data_ && size_)
+                munmap(const_cast<char *>(data_), size_);
+#endif
+        }
+
+        bool Open(const std::string & path)
+        {
+#ifdef _WIN32
+            std::ifstream file(path.c_str(), std::ios_base::binary);
+            if (!file.is_open())
+                return false;
+
+            copy_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            data_ = copy_.data();
+            size_ = copy_.size();
+            return true;
+#else
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                close(fd);
+                return false;
+            }
+
+            size_ = std::size_t(st.st_size);
+
+            if (size_)
+            {
+                void * data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                data_ = data == MAP_FAILED ? nullptr : static_cast<const char *>(data);
+            }
+
+            close(fd);
+            return data_ || !size_;
+#endif
+        }
+
+        const char * GetData() const { return data_; }
+        std::size_t GetSize() const { return size_; }
+
+        /// tells kernel which part will be read (read ahead only where needed)
+        void WillNeed(std::size_t begin, std::size_t end) const
+        {
+#ifndef _WIN32
+            std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+            begin -= begin % page;
+            madvise(const_cast<char *>(data_) + begin, end - begin, MADV_WILLNEED);
+#else
+            (void)begin;
+            (void)end;
+#endif
+        }
+
+    private:
+        const char * data_;
+        std::size_t size_;
+#ifdef _WIN32
+        std::string copy_;
+#endif
+    };
+
+    /// length of "YYYY-MM-DD HH:MM:SS.mmm"
+    const std::size_t timeSize = 23;
+
+    /// completes "YYYY-MM-DD[ HH[:MM[:SS[.mmm]]]]" to full time, returns false for other text
+    bool ParseTime(const char * text, std::string & out, std::int64_t & epochMs)
+    {
+        const char * full = "0000-00-00 00:00:00.000";
+        std::size_t size = std::strlen(text);
+
+        if (size != 10 && size != 13 && size != 16 && size != 19 && size != timeSize)
+            return false;
+
+        out.assign(text);
+        if (size > 10 && out[10] == 'T')
+            out[10] = ' ';
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            bool digit = full[i] == '0';
+            if (digit != (out[i] >= '0' && out[i] <= '9') || (!digit && out[i] != full[i]))
+                return false;
+        }
+
+        out.append(full + size);
+
+        std::tm tm;
+        std::memset(&tm, 0, sizeof(tm));
+        tm.tm_year = std::atoi(out.c_str()) - 1900;
+        tm.tm_mon = std::atoi(out.c_str() + 5) - 1;
+        tm.tm_mday = std::atoi(out.c_str() + 8);
+        tm.tm_hour = std::atoi(out.c_str() + 11);
+        tm.tm_min = std::atoi(out.c_str() + 14);
+        tm.tm_sec = std::atoi(out.c_str() + 17);
+        tm.tm_isdst = -1;
+
+        epochMs = std::int64_t(std::mktime(&tm)) * 1000 + std::atoi(out.c_str() + 20);
+        return true;
+    }
+
+    /// finds local time and level name of line in text, logfmt or JSON format,
+    /// returns false for line without them (continuation of multiline message)
+    bool ParseLine(const char * line, const char * end, char * time, const char *& level, std::size_t & levelSize)
+    {
+        std::size_t size = std::size_t(end - line);
+        const char * levelEnd = nullptr;
+
+        if (size > timeSize + 3 && line[timeSize] == ' ' && line[timeSize + 1] == '[')
+        {
+            // YYYY-MM-DD HH:MM:SS.mmm [LEVEL] msg
+            std::memcpy(time, line, timeSize);
+            level = line + timeSize + 2;
+            levelEnd = static_cast<const char *>(std::memchr(level, ']', std::size_t(end - level)));
+        }
+        else if (size > timeSize + 16 && std::memcmp(line, "ts=", 3) == 0)
+        {
+            // ts=YYYY-MM-DDTHH:MM:SS.mmm+hh:mm level=LEVEL ...
+            std::memcpy(time, line + 3, timeSize);
+            level = line + 3 + timeSize + 6 + 7;
+            levelEnd = std::find(level, end, ' ');
+            if (std::memcmp(level - 7, " level=", 7) != 0)
+                return false;
+        }
+        else if (size > timeSize + 24 && std::memcmp(line, "{\"ts\":\"", 7) == 0)
+        {
+            // {"ts":"YYYY-MM-DDTHH:MM:SS.mmm+hh:mm","level":"LEVEL",...
+            std::memcpy(time, line + 7, timeSize);
+            level = line + 7 + timeSize + 6 + 11;
+            levelEnd = std::find(level, end, '"');
+            if (std::memcmp(level - 11, "\",\"level\":\"", 11) != 0)
+                return false;
+        }
+        else
+            return false;
+
+        if (!levelEnd || levelEnd == end || time[4] != '-' || time[13] != ':' || time[19] != '.')
+            return false;
+
+        time[10] = ' ';
+        levelSize = std::size_t(levelEnd - level);
+        return true;
+    }
+
+    struct Query
+    {
+        std::string from;
+        std::string to;
+        std::int64_t fromMs;
+        std::int64_t toMs;
+        /// accepted level names (empty - all)
+        std::vector<std::string> levels;
+    };
+
+    /// matching lines of one file in file order (ranges are parts of file which can contain them)
+    class FileCursor
+    {
+    public:
+        FileCursor(const Query & query) : query_(query), range_(0), pos_(0), lineEnd_(0) {}
+
+        bool Open(const std::string & path)
+        {
+            if (!file_.Open(path))
+                return false;
+
+            std::size_t size = file_.GetSize();
+            std::vector<siof::LogIndexRecord> records;
+
+            if (!siof::LogIndexWriter::Read(path + SLOG_INDEX_EXTENSION, records))
+            {
+                AddRange(0, size);
+                return true;
+            }
+
+            std::sort(records.begin(), records.end(), [] (const siof::LogIndexRecord & a, const siof::LogIndexRecord & b) -> bool
+                        {
+                            return a.offset < b.offset;
+                        });
+
+            // parts without record (unfinished when process crashed, written before index) are always read
+            std::size_t pos = 0;
+
+            for (const siof::LogIndexRecord & record : records)
+            {
+                std::size_t begin = std::size_t(std::min<std::uint64_t>(record.offset, size));
+                std::size_t end = std::size_t(std::min<std::uint64_t>(record.offset + record.size, size));
+
+                if (begin > pos)
+                    AddRange(pos, begin);
+
+                if (record.maxTime >= query_.fromMs && record.minTime < query_.toMs)
+                    AddRange(begin, end);
+
+                pos = std::max(pos, end);
+            }
+
+            if (pos < size)
+                AddRange(pos, size);
+
+            return true;
+        }
+
+        /// moves to next matching line, returns false at end
+        bool Next()
+        {
+            const char * data = file_.GetData();
+
+            while (range_ < ranges_.size())
+            {
+                if (pos_ < ranges_[range_].first)
+                    pos_ = ranges_[range_].first;
+
+                std::size_t end = ranges_[range_].second;
+
+                if (pos_ >= end)
+                {
+                    ++range_;
+                    continue;
+                }
+
+                const char * begin = data + pos_;
+                const char * newLine = static_cast<const char *>(std::memchr(begin, '\n', end - pos_));
+                std::size_t lineEnd = newLine ? std::size_t(newLine - data) + 1 : end;
+
+                const char * level = nullptr;
+                std::size_t levelSize = 0;
+
+                if (!ParseLine(begin, data + lineEnd, time_, level, levelSize))
+                {
+                    // continuation line or separator - skipped with its line
+                    pos_ = lineEnd;
+                    continue;
+                }
+
+                // lines of multiline message follow
+                std::size_t messageEnd = lineEnd;
+                while (messageEnd < end)
+                {
+                    const char * next = data + messageEnd;
+                    const char * nextNewLine = static_cast<const char *>(std::memchr(next, '\n', end - messageEnd));
+                    std::size_t nextEnd = nextNewLine ? std::size_t(nextNewLine - data) + 1 : end;
+
+                    char nextTime[timeSize];
+                    const char * nextLevel = nullptr;
+                    std::size_t nextLevelSize = 0;
+
+                    if (ParseLine(next, data + nextEnd, nextTime, nextLevel, nextLevelSize))
+                        break;
+
+                    messageEnd = nextEnd;
+                }
+
+                pos_ = messageEnd;
+
+                if (!Matches(level, levelSize))
+                    continue;
+
+                line_ = begin;
+                lineEnd_ = messageEnd;
+                return true;
+            }
+
+            return false;
+        }
+
+        /// local time of current line ("YYYY-MM-DD HH:MM:SS.mmm")
+        const char * GetTime() const { return time_; }
+        const char * GetLine() const { return line_; }
+        std::size_t GetLineSize() const { return std::size_t(file_.GetData() + lineEnd_ - line_); }
+
+    private:
+        void AddRange(std::size_t begin, std::size_t end)
+        {
+            if (begin >= end)
+                return;
+
+            if (!ranges_.empty() && ranges_.back().second == begin)
+                ranges_.back().second = end;
+            else
+                ranges_.push_back(std::make_pair(begin, end));
+
+            file_.WillNeed(begin, end);
+        }
+
+        bool Matches(const char * level, std::size_t levelSize) const
+        {
+            if (std::memcmp(time_, query_.from.data(), timeSize) < 0 || std::memcmp(time_, query_.to.data(), timeSize) >= 0)
+                return false;
+
+            if (query_.levels.empty())
+                return true;
+
+            for (const std::string & name : query_.levels)
+            {
+                if (name.size() == levelSize && std::memcmp(name.data(), level, levelSize) == 0)
+                    return true;
+            }
+
+            return false;
+        }
+
+        const Query & query_;
+        MappedFile file_;
+        std::vector<std::pair<std::size_t, std::size_t> > ranges_;
+        std::size_t range_;
+        std::size_t pos_;
+
+        char time_[timeSize];
+        const char * line_;
+        std::size_t lineEnd_;
+    };
+}
+
+int main(int argc, char * argv[])
+{
+    std::ios_base::sync_with_stdio(false);
+
+    Query query;
+    query.from = "0000-00-00 00:00:00.000";
+    query.to = "9999-99-99 99:99:99.999";
+    query.fromMs = INT64_MIN;
+    query.toMs = INT64_MAX;
+
+    int first = 1;
+
+    for (; first + 1 < argc && argv[first][0] == '-'; first += 2)
+    {
+        const char * value = argv[first + 1];
+
+        if (std::strcmp(argv[first], "--from") == 0 || std::strcmp(argv[first], "--to") == 0)
+        {
+            bool from = argv[first][2] == 'f';
+            if (!ParseTime(value, from ? query.from : query.to, from ? query.fromMs : query.toMs))
+            {
+                std::cerr << "logquery: bad time " << value << std::endl;
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[first], "--level") == 0)
+        {
+            for (const char * p = value; *p; )
+            {
+                const char * comma = std::strchr(p, ',');
+                std::string name(p, comma ? comma : p + std::strlen(p));
+
+                std::transform(name.begin(), name.end(), name.begin(), [] (char c) -> char { return char(std::toupper(c)); });
+                query.levels.push_back(name);
+
+                p = comma ? comma + 1 : p + std::strlen(p);
+            }
+        }
+        else
+        {
+            std::cerr << "logquery: unknown option " << argv[first] << std::endl;
+            return 1;
+        }
+    }
+
+    if (first >= argc)
+    {
+        std::cerr << "usage: logquery [--from TIME] [--to TIME] [--level LEVEL[,LEVEL...]] file [file...]" << std::endl;
+        return 1;
+    }
+
+    int result = 0;
+    std::vector<std::unique_ptr<FileCursor> > cursors;
+
+    for (int i = first; i < argc; ++i)
+    {
+        std::unique_ptr<FileCursor> cursor(new FileCursor(query));
+
+        if (!cursor->Open(argv[i]))
+        {
+            std::cerr << "logquery: can't open " << argv[i] << std::endl;
+            result = 1;
+            continue;
+        }
+
+        if (cursor->Next())
+            cursors.push_back(std::move(cursor));
+    }
+
+    // few files (days, parts) - linear pick of earliest line is enough
+    while (!cursors.empty())
+    {
+        std::size_t earliest = 0;
+        for (std::size_t i = 1; i < cursors.size(); ++i)
+        {
+            if (std::memcmp(cursors[i]->GetTime(), cursors[earliest]->GetTime(), timeSize) < 0)
+                earliest = i;
+        }
+
+        FileCursor & cursor = *cursors[earliest];
+        std::fwrite(cursor.GetLine(), 1, cursor.GetLineSize(), stdout);
+
+        if (!cursor.Next())
+            cursors.erase(cursors.begin() + std::ptrdiff_t(earliest));
+    }
+
+    return result;
+}